@@ -0,0 +1,55 @@
+#include "Allocation_Counter.h"
+
+#ifdef DIMENSION_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> allocation_count(0);
+
+    void* counted_allocate(size_t size) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        void* memory = std::malloc(size == 0 ? 1 : size);
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+
+    void* counted_allocate_aligned(size_t size, std::align_val_t alignment) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        size_t align = static_cast<size_t>(alignment);
+        //aligned_alloc wants the size to be a multiple of the alignment
+        void* memory = std::aligned_alloc(align, (size + align - 1) / align * align);
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+}
+
+uint64_t get_allocation_count() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) { return counted_allocate(size); }
+void* operator new[](size_t size) { return counted_allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return counted_allocate_aligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return counted_allocate_aligned(size, alignment); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+
+#else
+
+uint64_t get_allocation_count() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+/*
+File Description:
+- Counts calls to the global operator new so hot loops can be checked for heap
+- traffic. Only does anything when built with -DDIMENSION_COUNT_ALLOCATIONS,
+- otherwise the count stays at zero and new/delete are left alone.
+*/
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+//Standard C Libraries
+#include <cstdint> //uint64_t
+
+//total heap allocations made through new on every thread since startup
+uint64_t get_allocation_count();
+
+#endif
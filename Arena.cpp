@@ -0,0 +1,55 @@
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+
+Arena::Arena(size_t block_size) : current_block(0), offset(0), block_size(block_size), used_bytes(0), peak_bytes(0) {}
+
+Arena::~Arena() {
+    for (auto& block : blocks) {
+        delete[] block.data;
+    }
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    while (current_block < blocks.size()) {
+        Block& block = blocks[current_block];
+        uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + offset;
+        size_t padding = (alignment - address % alignment) % alignment;
+        if (offset + padding + bytes <= block.size) {
+            offset += padding + bytes;
+            used_bytes += padding + bytes;
+            peak_bytes = std::max(peak_bytes, used_bytes);
+            return block.data + offset - bytes;
+        }
+        //does not fit, move on to the next block, the tail of this one stays unused until the next reset
+        current_block++;
+        offset = 0;
+    }
+
+    //out of blocks, only happens while the arena is still growing to its working size
+    size_t new_block_size = std::max(block_size, bytes + alignment);
+    blocks.push_back(Block{new char[new_block_size], new_block_size});
+    current_block = blocks.size() - 1;
+    offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void Arena::reset() {
+    current_block = 0;
+    offset = 0;
+    used_bytes = 0;
+}
+
+void Arena::rewind(const Marker& marker) {
+    current_block = marker.block;
+    offset = marker.offset;
+    used_bytes = marker.used_bytes;
+}
+
+size_t Arena::get_capacity() const {
+    size_t capacity = 0;
+    for (const auto& block : blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
@@ -0,0 +1,93 @@
+/*
+File Description:
+- Linear (bump) allocator for short lived data. Allocating is a pointer bump,
+- nothing is freed on its own, reset() rewinds the whole arena at once. Blocks
+- are kept between resets, so once an arena has grown to a frame's worth of
+- scratch space it stops touching the heap.
+- Arena_Allocator lets standard containers live in an arena and Arena_Scope
+- rewinds to where it started when it goes out of scope, for temporaries
+- inside a longer job like loading a file.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+//Standard C Libraries
+#include <vector>   //block list
+#include <cstddef>  //size_t, max_align_t
+
+class Arena {
+    private:
+        struct Block {
+            char* data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t current_block;  //blocks before this one are full, blocks after it are spare from an earlier reset
+        size_t offset;         //bytes used in the current block
+        size_t block_size;
+        size_t used_bytes;
+        size_t peak_bytes;
+
+    public:
+        explicit Arena(size_t block_size = 1 << 20);
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+        template <typename T>
+        T* allocate_array(size_t count) { return static_cast<T*>(allocate(sizeof(T) * count, alignof(T))); }
+
+        void reset();  //O(1), everything allocated so far is gone
+
+        //where the arena is right now, rewind() goes back to it and drops everything allocated since
+        struct Marker {
+            size_t block;
+            size_t offset;
+            size_t used_bytes;
+        };
+        Marker mark() const { return Marker{current_block, offset, used_bytes}; }
+        void rewind(const Marker& marker);
+
+        size_t get_used_bytes() const { return used_bytes; }
+        size_t get_peak_bytes() const { return peak_bytes; }
+        size_t get_capacity() const;
+};
+
+//rewinds the arena to where it was when this was created
+class Arena_Scope {
+    private:
+        Arena& arena;
+        Arena::Marker marker;
+
+    public:
+        explicit Arena_Scope(Arena& arena) : arena(arena), marker(arena.mark()) {}
+        ~Arena_Scope() { arena.rewind(marker); }
+        Arena_Scope(const Arena_Scope&) = delete;
+        Arena_Scope& operator=(const Arena_Scope&) = delete;
+};
+
+//standard allocator interface on top of an arena, deallocate does nothing since the arena frees everything at once
+template <typename T>
+struct Arena_Allocator {
+    typedef T value_type;
+    Arena* arena;
+
+    explicit Arena_Allocator(Arena& arena) : arena(&arena) {}
+    template <typename U>
+    Arena_Allocator(const Arena_Allocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocate_array<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const Arena_Allocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const Arena_Allocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using Arena_Vector = std::vector<T, Arena_Allocator<T>>;
+
+#endif
@@ -0,0 +1,200 @@
+#include "Asset_Manager.h"
+#include "Loader.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    //splits a path into the directory inotify watches and the file name its events report
+    void split_path(const std::string& file_path, std::string& directory, std::string& file_name) {
+        size_t slash = file_path.find_last_of('/');
+        directory = slash == std::string::npos ? "." : file_path.substr(0, slash);
+        file_name = slash == std::string::npos ? file_path : file_path.substr(slash + 1);
+    }
+}
+
+Asset_Manager::Asset_Manager(int worker_count)
+    : loaders(worker_count), placeholder(make_placeholder()), inotify_descriptor(-1), stopping(false) {
+#ifdef __linux__
+    inotify_descriptor = inotify_init1(IN_NONBLOCK);
+    if (inotify_descriptor == -1) {
+        std::cerr << "inotify unavailable, assets will not hot reload" << std::endl;
+    } else {
+        watcher = std::thread(&Asset_Manager::watch_loop, this);
+    }
+#endif
+}
+
+Asset_Manager::~Asset_Manager() {
+    stopping = true;
+    if (watcher.joinable()) {
+        watcher.join();
+    }
+#ifdef __linux__
+    if (inotify_descriptor != -1) {
+        close(inotify_descriptor);
+    }
+#endif
+    loaders.wait();  //loads still running hold a pointer to this manager
+}
+
+Asset_Handle Asset_Manager::load(const std::string& obj_file_path, const std::string& mtl_file_path) {
+    std::lock_guard<std::mutex> lock(assets_mutex);
+    Asset_Handle handle = static_cast<Asset_Handle>(assets.size());
+    assets.emplace_back();
+    assets.back().obj_file_path = obj_file_path;
+    assets.back().mtl_file_path = mtl_file_path;
+    watch_file(obj_file_path);
+    watch_file(mtl_file_path);
+    schedule_load(handle);
+    return handle;
+}
+
+void Asset_Manager::schedule_load(Asset_Handle handle) {
+    Asset& asset = assets[handle];
+    if (asset.loading) {
+        //one load per asset at a time, the running one will start another when it finishes
+        asset.reload_requested = true;
+        return;
+    }
+    asset.loading = true;
+    std::string obj_file_path = asset.obj_file_path;
+    std::string mtl_file_path = asset.mtl_file_path;
+
+    loaders.submit([this, handle, obj_file_path, mtl_file_path]() {
+        std::shared_ptr<Model> model = std::make_shared<Model>(Loader::load_obj(obj_file_path, mtl_file_path));
+
+        std::lock_guard<std::mutex> lock(assets_mutex);
+        Asset& finished = assets[handle];
+        finished.loading = false;
+        if (model->get_faces().empty()) {
+            //a half written file or a typo mid edit, keep showing whatever was there before
+            std::cerr << "Failed to load asset: " << obj_file_path << std::endl;
+        } else {
+            finished.pending = model;
+        }
+        if (finished.reload_requested) {
+            finished.reload_requested = false;
+            schedule_load(handle);
+        }
+    });
+}
+
+int Asset_Manager::update() {
+    //the only place a model gets replaced, so nothing the renderer holds from get() changes mid frame
+    int swapped = 0;
+    std::lock_guard<std::mutex> lock(assets_mutex);
+    for (auto& asset : assets) {
+        if (asset.pending) {
+            asset.current = std::move(asset.pending);
+            asset.pending.reset();
+            swapped++;
+        }
+    }
+    return swapped;
+}
+
+Model& Asset_Manager::get(Asset_Handle handle) {
+    Asset& asset = assets[handle];
+    return asset.current ? *asset.current : placeholder;
+}
+
+bool Asset_Manager::is_ready(Asset_Handle handle) const {
+    return static_cast<bool>(assets[handle].current);
+}
+
+//-------------------------------------Hot_Reload-------------------------------------------------
+void Asset_Manager::watch_file(const std::string& file_path) {
+#ifdef __linux__
+    if (inotify_descriptor == -1) {
+        return;
+    }
+    std::string directory, file_name;
+    split_path(file_path, directory, file_name);
+    //the directory is watched rather than the file, editors usually save by writing a new file and renaming it over the old one
+    int watch_descriptor = inotify_add_watch(inotify_descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor != -1) {
+        watched_directories[watch_descriptor] = directory;
+    }
+#endif
+}
+
+void Asset_Manager::watch_loop() {
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    while (!stopping) {
+        //wake up regularly to check for shutdown
+        pollfd poll_descriptor{inotify_descriptor, POLLIN, 0};
+        if (poll(&poll_descriptor, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t length = read(inotify_descriptor, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(assets_mutex);
+        for (char* position = buffer; position < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+            position += sizeof(inotify_event) + event->len;
+            auto directory = watched_directories.find(event->wd);
+            if (event->len == 0 || directory == watched_directories.end()) {
+                continue;
+            }
+
+            for (Asset_Handle handle = 0; handle < static_cast<Asset_Handle>(assets.size()); ++handle) {
+                std::string obj_directory, obj_name, mtl_directory, mtl_name;
+                split_path(assets[handle].obj_file_path, obj_directory, obj_name);
+                split_path(assets[handle].mtl_file_path, mtl_directory, mtl_name);
+                if ((directory->second == obj_directory && obj_name == event->name)
+                    || (directory->second == mtl_directory && mtl_name == event->name)) {
+                    schedule_load(handle);
+                }
+            }
+        }
+    }
+#endif
+}
+
+//-------------------------------------Placeholder------------------------------------------------
+Model Asset_Manager::make_placeholder() {
+    //a plain grey 2x2x2 cube, enough to show where the real model is going to be
+    Model cube;
+    Material material = Material();
+    material.name = "placeholder";
+    material.diffuse_color = Color{0.6f, 0.6f, 0.6f, 1.0f};
+    material.dissolve_factor = 1.0f;
+    cube.add_material(material);
+    Material& cube_material = *cube.find_material("placeholder");
+
+    for (int i = 0; i < 8; ++i) {
+        cube.add_vertex(Vector3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f));
+    }
+    Vector3 side_normals[6] = {
+        Vector3(-1, 0, 0), Vector3(1, 0, 0), Vector3(0, -1, 0), Vector3(0, 1, 0), Vector3(0, 0, -1), Vector3(0, 0, 1)
+    };
+    //corners of each side wound counter clockwise when looking at it from outside
+    int sides[6][4] = {
+        {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}
+    };
+    for (int side = 0; side < 6; ++side) {
+        cube.add_normal(side_normals[side]);
+        for (int i = 2; i < 4; ++i) {
+            Face face(cube_material);
+            int corners[3] = {sides[side][0], sides[side][i - 1], sides[side][i]};
+            for (int corner = 0; corner < 3; ++corner) {
+                face.vertex_index[corner] = corners[corner];
+                face.texture_index[corner] = -1;
+                face.normal_index[corner] = side;
+            }
+            cube.add_face(face);
+        }
+    }
+    cube.find_origin();
+    cube.build_adjacency();
+    cube.build_meshlets();
+    return cube;
+}
@@ -0,0 +1,69 @@
+/*
+File Description:
+- Loads OBJ/MTL pairs on background threads so the frame loop never waits on
+- the disk. load() hands back a handle straight away, get() returns a stand in
+- cube until the model is ready, and update() swaps finished models in between
+- frames. Files that change on disk are picked up through inotify and reloaded
+- the same way.
+
+Library Resources:
+- inotify (Linux), https://man7.org/linux/man-pages/man7/inotify.7.html
+*/
+
+#ifndef ASSET_MANAGER_H
+#define ASSET_MANAGER_H
+//Standard C Libraries
+#include <deque>    //asset slots, handles stay valid as it grows
+#include <map>      //inotify watch lookup
+#include <memory>   //shared model ownership between loader and renderer
+#include <mutex>    //guards pending results
+#include <atomic>   //watcher shutdown flag
+#include <thread>   //file watcher
+#include <string>   //file paths
+//Created Files
+#include "Model.h"
+#include "Thread_Pool.h"
+
+typedef int Asset_Handle;
+
+class Asset_Manager {
+    private:
+        struct Asset {
+            std::string obj_file_path;
+            std::string mtl_file_path;
+            std::shared_ptr<Model> current;  //only touched by the render thread
+            std::shared_ptr<Model> pending;  //finished load waiting for update(), guarded by assets_mutex
+            bool loading = false;
+            bool reload_requested = false;   //the files changed again while a load was running
+        };
+
+        std::deque<Asset> assets;
+        std::mutex assets_mutex;
+        Thread_Pool loaders;
+        Model placeholder;
+
+        int inotify_descriptor;
+        std::map<int, std::string> watched_directories;  //watch descriptor to directory
+        std::atomic<bool> stopping;
+        std::thread watcher;
+
+        void schedule_load(Asset_Handle handle);  //expects assets_mutex to be held
+        void watch_file(const std::string& file_path);
+        void watch_loop();
+
+    public:
+        explicit Asset_Manager(int worker_count = 2);
+        ~Asset_Manager();
+        Asset_Manager(const Asset_Manager&) = delete;
+        Asset_Manager& operator=(const Asset_Manager&) = delete;
+
+        Asset_Handle load(const std::string& obj_file_path, const std::string& mtl_file_path);
+        int update();  //call once per frame from the render thread, returns how many models were swapped in
+
+        Model& get(Asset_Handle handle);
+        bool is_ready(Asset_Handle handle) const;
+
+        static Model make_placeholder();
+};
+
+#endif
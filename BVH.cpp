@@ -0,0 +1,468 @@
+#include "BVH.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    const int BIN_COUNT = 16;        //candidate split planes per axis
+    const int MAX_LEAF_SIZE = 8;     //never leave more than this in a leaf even if the SAH says splitting is not worth it
+    const int MAX_SAH_DEPTH = 64;    //past this the build stops trusting the SAH and halves every node instead
+    const int TRAVERSAL_STACK_SIZE = 128;
+    //halving a run of at most 2^31 triangles takes 31 more levels, and traversal pushes at most one node per level
+    static_assert(MAX_SAH_DEPTH + 32 < TRAVERSAL_STACK_SIZE, "the deepest tree the build can make has to fit the traversal stack");
+    const float HIT_EPSILON = 1e-4f; //keeps shadow and reflection rays from hitting the face they start on
+
+    float axis_value(const Vector3& v, int axis) {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    Vector3 component_min(const Vector3& a, const Vector3& b) {
+        return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+    }
+
+    Vector3 component_max(const Vector3& a, const Vector3& b) {
+        return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+    }
+
+    //half the surface area, the SAH only ever compares areas so the factor of two does not matter
+    float half_area(const Vector3& bounds_min, const Vector3& bounds_max) {
+        Vector3 extent = bounds_max - bounds_min;
+        if (extent.x < 0 || extent.y < 0 || extent.z < 0) {
+            return 0.0f;
+        }
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+
+    //returns the distance the ray enters the box at, or max float when it misses or enters past max_distance
+    float intersect_box(const BVH_Node& node, const Vector3& origin, const Vector3& inverse, float max_distance) {
+        float t1x = (node.bounds_min.x - origin.x) * inverse.x, t2x = (node.bounds_max.x - origin.x) * inverse.x;
+        float t1y = (node.bounds_min.y - origin.y) * inverse.y, t2y = (node.bounds_max.y - origin.y) * inverse.y;
+        float t1z = (node.bounds_min.z - origin.z) * inverse.z, t2z = (node.bounds_max.z - origin.z) * inverse.z;
+        float t_enter = std::max({std::min(t1x, t2x), std::min(t1y, t2y), std::min(t1z, t2z), 0.0f});
+        float t_exit = std::min({std::max(t1x, t2x), std::max(t1y, t2y), std::max(t1z, t2z), max_distance});
+        return t_enter <= t_exit ? t_enter : std::numeric_limits<float>::max();
+    }
+
+    //moller trumbore, two sided since the rasterizer does not cull back faces either
+    bool intersect_triangle(const BVH_Triangle& triangle, const Ray& ray, float& distance, float& u, float& v) {
+        Vector3 p = cross_product(ray.direction, triangle.edge_2);
+        float determinant = dot_product(triangle.edge_1, p);
+        if (std::fabs(determinant) < 1e-12f) {
+            return false;  //ray runs parallel to the triangle
+        }
+        float inverse_determinant = 1.0f / determinant;
+        Vector3 s = ray.origin - triangle.vertex_0;
+        float hit_u = dot_product(s, p) * inverse_determinant;
+        if (hit_u < 0.0f || hit_u > 1.0f) {
+            return false;
+        }
+        Vector3 q = cross_product(s, triangle.edge_1);
+        float hit_v = dot_product(ray.direction, q) * inverse_determinant;
+        if (hit_v < 0.0f || hit_u + hit_v > 1.0f) {
+            return false;
+        }
+        float t = dot_product(triangle.edge_2, q) * inverse_determinant;
+        if (t <= HIT_EPSILON || t >= distance) {
+            return false;
+        }
+        distance = t;
+        u = hit_u;
+        v = hit_v;
+        return true;
+    }
+
+    Vector3 inverse_direction(const Vector3& direction) {
+        //a zero component becomes infinity, which the slab test handles on its own
+        return Vector3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    }
+
+    BVH_Triangle make_triangle(const Model& model, int face_index) {
+        const Face& face = model.get_faces()[face_index];
+        const std::vector<Vector3>& vertices = model.get_vertices();
+        const Vector3& vertex_0 = vertices[face.vertex_index[0]];
+        return BVH_Triangle{
+            vertex_0,
+            vertices[face.vertex_index[1]] - vertex_0,
+            vertices[face.vertex_index[2]] - vertex_0,
+            face_index
+        };
+    }
+}
+
+//-------------------------------------Ray_Packet-------------------------------------------------
+void Ray_Packet::set_ray(int lane, const Ray& ray) {
+    origin_x[lane] = ray.origin.x;
+    origin_y[lane] = ray.origin.y;
+    origin_z[lane] = ray.origin.z;
+    direction_x[lane] = ray.direction.x;
+    direction_y[lane] = ray.direction.y;
+    direction_z[lane] = ray.direction.z;
+    inverse_x[lane] = 1.0f / ray.direction.x;
+    inverse_y[lane] = 1.0f / ray.direction.y;
+    inverse_z[lane] = 1.0f / ray.direction.z;
+    distance[lane] = std::numeric_limits<float>::max();
+    u[lane] = 0.0f;
+    v[lane] = 0.0f;
+    face_index[lane] = -1;
+}
+
+Ray_Hit Ray_Packet::get_hit(int lane) const {
+    Ray_Hit hit;
+    hit.distance = distance[lane];
+    hit.face_index = face_index[lane];
+    hit.u = u[lane];
+    hit.v = v[lane];
+    return hit;
+}
+
+//-------------------------------------Building---------------------------------------------------
+void BVH::build(const Model& model) {
+    nodes.clear();
+    triangles.clear();
+    if (!model.has_vertex_streams()) {
+        std::cerr << "Cannot build a BVH over a model whose vertex streams were released" << std::endl;
+        return;
+    }
+
+    int face_count = static_cast<int>(model.get_faces().size());
+    if (face_count == 0) {
+        return;
+    }
+
+    triangles.reserve(face_count);
+    std::vector<Vector3> centroids;
+    centroids.reserve(face_count);
+    for (int i = 0; i < face_count; ++i) {
+        BVH_Triangle triangle = make_triangle(model, i);
+        triangles.push_back(triangle);
+        centroids.push_back(triangle.vertex_0 + (triangle.edge_1 + triangle.edge_2) / 3.0f);
+    }
+
+    //a binary tree with one triangle per leaf has 2n - 1 nodes, so this is the most we can ever need
+    nodes.reserve(2 * face_count - 1);
+    build_node(0, face_count, centroids, 0);
+}
+
+void BVH::compute_bounds(BVH_Node& node, int first, int count) const {
+    node.bounds_min = Vector3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    node.bounds_max = -node.bounds_min;
+    for (int i = first; i < first + count; ++i) {
+        const BVH_Triangle& triangle = triangles[i];
+        Vector3 vertex_1 = triangle.vertex_0 + triangle.edge_1;
+        Vector3 vertex_2 = triangle.vertex_0 + triangle.edge_2;
+        node.bounds_min = component_min(node.bounds_min, component_min(triangle.vertex_0, component_min(vertex_1, vertex_2)));
+        node.bounds_max = component_max(node.bounds_max, component_max(triangle.vertex_0, component_max(vertex_1, vertex_2)));
+    }
+}
+
+void BVH::split_at_median(int first, int count, std::vector<Vector3>& centroids, int axis) {
+    //only the half each triangle ends up in matters, so a partial sort around the middle is enough
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), first);
+    std::nth_element(order.begin(), order.begin() + count / 2, order.end(), [&](int a, int b) {
+        return axis_value(centroids[a], axis) < axis_value(centroids[b], axis);
+    });
+    std::vector<BVH_Triangle> sorted_triangles;
+    std::vector<Vector3> sorted_centroids;
+    sorted_triangles.reserve(count);
+    sorted_centroids.reserve(count);
+    for (int index : order) {
+        sorted_triangles.push_back(triangles[index]);
+        sorted_centroids.push_back(centroids[index]);
+    }
+    std::copy(sorted_triangles.begin(), sorted_triangles.end(), triangles.begin() + first);
+    std::copy(sorted_centroids.begin(), sorted_centroids.end(), centroids.begin() + first);
+}
+
+void BVH::build_node(int first, int count, std::vector<Vector3>& centroids, int depth) {
+    int node_index = static_cast<int>(nodes.size());
+    nodes.push_back(BVH_Node());
+    compute_bounds(nodes[node_index], first, count);
+    nodes[node_index].first_or_right = first;
+    nodes[node_index].triangle_count = count;
+    if (count <= 2) {
+        return;
+    }
+
+    Vector3 centroid_min = centroids[first];
+    Vector3 centroid_max = centroids[first];
+    for (int i = first + 1; i < first + count; ++i) {
+        centroid_min = component_min(centroid_min, centroids[i]);
+        centroid_max = component_max(centroid_max, centroids[i]);
+    }
+
+    //skewed input (far outliers, exponentially spaced geometry) can make the SAH peel a few triangles off per level,
+    //once that has gone on this long halve the run along its widest axis so the depth stays bounded
+    if (depth >= MAX_SAH_DEPTH) {
+        Vector3 extent = centroid_max - centroid_min;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        split_at_median(first, count, centroids, axis);
+        nodes[node_index].triangle_count = 0;
+        build_node(first, count / 2, centroids, depth + 1);
+        nodes[node_index].first_or_right = static_cast<int>(nodes.size());
+        build_node(first + count / 2, count - count / 2, centroids, depth + 1);
+        return;
+    }
+
+    //binned SAH, drop every centroid into one of BIN_COUNT slices per axis and try each slice boundary as the split
+    struct Bin {
+        Vector3 bounds_min, bounds_max;
+        int count;
+    };
+    int best_axis = -1;
+    int best_split = 0;
+    float best_cost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; ++axis) {
+        float axis_min = axis_value(centroid_min, axis);
+        float extent = axis_value(centroid_max, axis) - axis_min;
+        if (extent <= 0.0f) {
+            continue;
+        }
+
+        Bin bins[BIN_COUNT];
+        for (Bin& bin : bins) {
+            bin.bounds_min = Vector3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+            bin.bounds_max = -bin.bounds_min;
+            bin.count = 0;
+        }
+        float bin_scale = BIN_COUNT / extent;
+        for (int i = first; i < first + count; ++i) {
+            int bin_index = std::min(BIN_COUNT - 1, static_cast<int>((axis_value(centroids[i], axis) - axis_min) * bin_scale));
+            const BVH_Triangle& triangle = triangles[i];
+            Vector3 vertex_1 = triangle.vertex_0 + triangle.edge_1;
+            Vector3 vertex_2 = triangle.vertex_0 + triangle.edge_2;
+            bins[bin_index].bounds_min = component_min(bins[bin_index].bounds_min, component_min(triangle.vertex_0, component_min(vertex_1, vertex_2)));
+            bins[bin_index].bounds_max = component_max(bins[bin_index].bounds_max, component_max(triangle.vertex_0, component_max(vertex_1, vertex_2)));
+            bins[bin_index].count++;
+        }
+
+        //sweep from the right once so each split's right side cost is a lookup
+        float right_area[BIN_COUNT];
+        int right_count[BIN_COUNT];
+        Vector3 sweep_min = bins[BIN_COUNT - 1].bounds_min;
+        Vector3 sweep_max = bins[BIN_COUNT - 1].bounds_max;
+        int sweep_count = 0;
+        for (int i = BIN_COUNT - 1; i > 0; --i) {
+            sweep_min = component_min(sweep_min, bins[i].bounds_min);
+            sweep_max = component_max(sweep_max, bins[i].bounds_max);
+            sweep_count += bins[i].count;
+            right_area[i] = half_area(sweep_min, sweep_max);
+            right_count[i] = sweep_count;
+        }
+
+        sweep_min = bins[0].bounds_min;
+        sweep_max = bins[0].bounds_max;
+        sweep_count = 0;
+        for (int split = 1; split < BIN_COUNT; ++split) {
+            sweep_min = component_min(sweep_min, bins[split - 1].bounds_min);
+            sweep_max = component_max(sweep_max, bins[split - 1].bounds_max);
+            sweep_count += bins[split - 1].count;
+            if (sweep_count == 0 || right_count[split] == 0) {
+                continue;
+            }
+            float cost = sweep_count * half_area(sweep_min, sweep_max) + right_count[split] * right_area[split];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    //turn the split cost into the same units as testing every triangle in this node, one traversal step costs about one triangle test
+    float parent_area = half_area(nodes[node_index].bounds_min, nodes[node_index].bounds_max);
+    float split_cost = parent_area > 0.0f ? 1.0f + best_cost / parent_area : std::numeric_limits<float>::max();
+    if (best_axis == -1 || split_cost >= count) {
+        if (count <= MAX_LEAF_SIZE) {
+            return;
+        }
+    }
+
+    int left_count = 0;
+    if (best_axis != -1) {
+        float axis_min = axis_value(centroid_min, best_axis);
+        float bin_scale = BIN_COUNT / (axis_value(centroid_max, best_axis) - axis_min);
+        int i = first;
+        int j = first + count - 1;
+        while (i <= j) {
+            int bin_index = std::min(BIN_COUNT - 1, static_cast<int>((axis_value(centroids[i], best_axis) - axis_min) * bin_scale));
+            if (bin_index < best_split) {
+                i++;
+            } else {
+                std::swap(triangles[i], triangles[j]);
+                std::swap(centroids[i], centroids[j]);
+                j--;
+            }
+        }
+        left_count = i - first;
+    }
+    if (left_count == 0 || left_count == count) {
+        //every centroid landed in the same spot, split the run in half so the leaf size limit still holds
+        left_count = count / 2;
+    }
+
+    nodes[node_index].triangle_count = 0;
+    build_node(first, left_count, centroids, depth + 1);
+    nodes[node_index].first_or_right = static_cast<int>(nodes.size());
+    build_node(first + left_count, count - left_count, centroids, depth + 1);
+}
+
+void BVH::refit(const Model& model) {
+    if (!model.has_vertex_streams()) {
+        return;  //a released model is frozen, the last fit still holds
+    }
+    for (auto& triangle : triangles) {
+        triangle = make_triangle(model, triangle.face_index);
+    }
+    //children always come after their parent, so walking backwards sees both children before the parent
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+        BVH_Node& node = nodes[i];
+        if (node.triangle_count > 0) {
+            compute_bounds(node, node.first_or_right, node.triangle_count);
+        } else {
+            const BVH_Node& left = nodes[i + 1];
+            const BVH_Node& right = nodes[node.first_or_right];
+            node.bounds_min = component_min(left.bounds_min, right.bounds_min);
+            node.bounds_max = component_max(left.bounds_max, right.bounds_max);
+        }
+    }
+}
+
+//-------------------------------------Traversal--------------------------------------------------
+bool BVH::intersect(const Ray& ray, Ray_Hit& hit) const {
+    if (nodes.empty()) {
+        return false;
+    }
+    Vector3 inverse = inverse_direction(ray.direction);
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    bool found = false;
+
+    while (stack_size > 0) {
+        int node_index = stack[--stack_size];
+        const BVH_Node& node = nodes[node_index];
+        if (intersect_box(node, ray.origin, inverse, hit.distance) == std::numeric_limits<float>::max()) {
+            continue;
+        }
+        if (node.triangle_count > 0) {
+            for (int i = node.first_or_right; i < node.first_or_right + node.triangle_count; ++i) {
+                if (intersect_triangle(triangles[i], ray, hit.distance, hit.u, hit.v)) {
+                    hit.face_index = triangles[i].face_index;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        //visit the closer child first so the far one is usually rejected by the shrunken hit distance
+        int left = node_index + 1;
+        int right = node.first_or_right;
+        float left_distance = intersect_box(nodes[left], ray.origin, inverse, hit.distance);
+        float right_distance = intersect_box(nodes[right], ray.origin, inverse, hit.distance);
+        if (left_distance > right_distance) {
+            std::swap(left, right);
+            std::swap(left_distance, right_distance);
+        }
+        if (right_distance != std::numeric_limits<float>::max()) {
+            stack[stack_size++] = right;
+        }
+        if (left_distance != std::numeric_limits<float>::max()) {
+            stack[stack_size++] = left;
+        }
+    }
+    return found;
+}
+
+bool BVH::occluded(const Ray& ray, float max_distance) const {
+    if (nodes.empty()) {
+        return false;
+    }
+    Vector3 inverse = inverse_direction(ray.direction);
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        int node_index = stack[--stack_size];
+        const BVH_Node& node = nodes[node_index];
+        if (intersect_box(node, ray.origin, inverse, max_distance) == std::numeric_limits<float>::max()) {
+            continue;
+        }
+        if (node.triangle_count > 0) {
+            for (int i = node.first_or_right; i < node.first_or_right + node.triangle_count; ++i) {
+                float distance = max_distance, u, v;
+                if (intersect_triangle(triangles[i], ray, distance, u, v)) {
+                    return true;  //any hit will do for a shadow
+                }
+            }
+            continue;
+        }
+        stack[stack_size++] = node.first_or_right;
+        stack[stack_size++] = node_index + 1;
+    }
+    return false;
+}
+
+void BVH::intersect_packet(Ray_Packet& packet) const {
+    if (nodes.empty()) {
+        return;
+    }
+    int stack[TRAVERSAL_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        int node_index = stack[--stack_size];
+        const BVH_Node& node = nodes[node_index];
+
+        //slab test for all four rays at once, the node is entered if any of them hits it
+        bool any_hit = false;
+        for (int lane = 0; lane < PACKET_SIZE; ++lane) {
+            float t1x = (node.bounds_min.x - packet.origin_x[lane]) * packet.inverse_x[lane];
+            float t2x = (node.bounds_max.x - packet.origin_x[lane]) * packet.inverse_x[lane];
+            float t1y = (node.bounds_min.y - packet.origin_y[lane]) * packet.inverse_y[lane];
+            float t2y = (node.bounds_max.y - packet.origin_y[lane]) * packet.inverse_y[lane];
+            float t1z = (node.bounds_min.z - packet.origin_z[lane]) * packet.inverse_z[lane];
+            float t2z = (node.bounds_max.z - packet.origin_z[lane]) * packet.inverse_z[lane];
+            float t_enter = std::max(std::max(std::min(t1x, t2x), std::min(t1y, t2y)), std::max(std::min(t1z, t2z), 0.0f));
+            float t_exit = std::min(std::min(std::max(t1x, t2x), std::max(t1y, t2y)), std::min(std::max(t1z, t2z), packet.distance[lane]));
+            any_hit |= t_enter <= t_exit;
+        }
+        if (!any_hit) {
+            continue;
+        }
+
+        if (node.triangle_count > 0) {
+            for (int i = node.first_or_right; i < node.first_or_right + node.triangle_count; ++i) {
+                const BVH_Triangle& triangle = triangles[i];
+                //same moller trumbore as the single ray version, but branch free so all lanes run the same instructions
+                for (int lane = 0; lane < PACKET_SIZE; ++lane) {
+                    float px = packet.direction_y[lane] * triangle.edge_2.z - packet.direction_z[lane] * triangle.edge_2.y;
+                    float py = packet.direction_z[lane] * triangle.edge_2.x - packet.direction_x[lane] * triangle.edge_2.z;
+                    float pz = packet.direction_x[lane] * triangle.edge_2.y - packet.direction_y[lane] * triangle.edge_2.x;
+                    float determinant = triangle.edge_1.x * px + triangle.edge_1.y * py + triangle.edge_1.z * pz;
+                    float inverse_determinant = 1.0f / determinant;
+                    float sx = packet.origin_x[lane] - triangle.vertex_0.x;
+                    float sy = packet.origin_y[lane] - triangle.vertex_0.y;
+                    float sz = packet.origin_z[lane] - triangle.vertex_0.z;
+                    float hit_u = (sx * px + sy * py + sz * pz) * inverse_determinant;
+                    float qx = sy * triangle.edge_1.z - sz * triangle.edge_1.y;
+                    float qy = sz * triangle.edge_1.x - sx * triangle.edge_1.z;
+                    float qz = sx * triangle.edge_1.y - sy * triangle.edge_1.x;
+                    float hit_v = (packet.direction_x[lane] * qx + packet.direction_y[lane] * qy + packet.direction_z[lane] * qz) * inverse_determinant;
+                    float t = (triangle.edge_2.x * qx + triangle.edge_2.y * qy + triangle.edge_2.z * qz) * inverse_determinant;
+
+                    bool accept = std::fabs(determinant) >= 1e-12f && hit_u >= 0.0f && hit_v >= 0.0f && hit_u + hit_v <= 1.0f
+                                  && t > HIT_EPSILON && t < packet.distance[lane];
+                    packet.distance[lane] = accept ? t : packet.distance[lane];
+                    packet.u[lane] = accept ? hit_u : packet.u[lane];
+                    packet.v[lane] = accept ? hit_v : packet.v[lane];
+                    packet.face_index[lane] = accept ? triangle.face_index : packet.face_index[lane];
+                }
+            }
+            continue;
+        }
+        stack[stack_size++] = node.first_or_right;
+        stack[stack_size++] = node_index + 1;
+    }
+}
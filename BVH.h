@@ -0,0 +1,78 @@
+/*
+File Description:
+- Bounding volume hierarchy over the faces of a model, used to answer ray
+- queries (picking, shadows, reflections, the ray traced render mode).
+- Splits are picked with the surface area heuristic and the tree is stored
+- flat in depth first order: the left child always sits right after its parent,
+- so a node only has to remember where its right child is.
+
+Important References:
+- https://jacco.ompf2.com/2022/04/13/how-to-build-a-bvh-part-1-basics/
+- https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
+*/
+
+#ifndef BVH_H
+#define BVH_H
+//Standard C Libraries
+#include <vector>   //node and triangle storage
+#include <limits>   //miss distance
+//Created Files
+#include "Model.h"
+#include "Utilities.h"
+
+struct Ray_Hit {
+    float distance = std::numeric_limits<float>::max();
+    int face_index = -1;     //index into Model::get_faces(), -1 on a miss
+    float u = 0.0f, v = 0.0f; //barycentric weights of vertex 1 and 2
+};
+
+//four rays stored lane by lane, every per ray loop runs over the same four slots so the compiler can keep them in one register
+const int PACKET_SIZE = 4;
+struct Ray_Packet {
+    float origin_x[PACKET_SIZE], origin_y[PACKET_SIZE], origin_z[PACKET_SIZE];
+    float direction_x[PACKET_SIZE], direction_y[PACKET_SIZE], direction_z[PACKET_SIZE];
+    float inverse_x[PACKET_SIZE], inverse_y[PACKET_SIZE], inverse_z[PACKET_SIZE];
+    float distance[PACKET_SIZE];
+    float u[PACKET_SIZE], v[PACKET_SIZE];
+    int face_index[PACKET_SIZE];
+
+    void set_ray(int lane, const Ray& ray);
+    Ray_Hit get_hit(int lane) const;
+};
+
+struct alignas(32) BVH_Node {
+    Vector3 bounds_min;
+    int first_or_right;  //leaf: first triangle, interior: index of the right child
+    Vector3 bounds_max;
+    int triangle_count;  //0 for interior nodes
+};
+
+struct BVH_Triangle {
+    Vector3 vertex_0;
+    Vector3 edge_1;   //vertex_1 - vertex_0
+    Vector3 edge_2;   //vertex_2 - vertex_0
+    int face_index;
+};
+
+class BVH {
+    private:
+        std::vector<BVH_Node> nodes;
+        std::vector<BVH_Triangle> triangles;  //reordered during the build so every leaf owns a contiguous run
+
+        void build_node(int first, int count, std::vector<Vector3>& centroids, int depth);
+        void split_at_median(int first, int count, std::vector<Vector3>& centroids, int axis);
+        void compute_bounds(BVH_Node& node, int first, int count) const;
+
+    public:
+        void build(const Model& model);
+        void refit(const Model& model); //keeps the topology, only updates bounds, much cheaper than a rebuild after a transform
+
+        bool intersect(const Ray& ray, Ray_Hit& hit) const;
+        bool occluded(const Ray& ray, float max_distance) const;
+        void intersect_packet(Ray_Packet& packet) const;
+
+        bool empty() const { return nodes.empty(); }
+        const std::vector<BVH_Node>& get_nodes() const { return nodes; }
+};
+
+#endif
@@ -63,9 +63,68 @@ void Camera::define_viewing_volume() {
     viewing_volume.far_corners[1] = center_far + (right * far_width * 0.5f) + (up * far_height * 0.5f);
     viewing_volume.far_corners[2] = center_far - (right * far_width * 0.5f) + (up * far_height * 0.5f);
     viewing_volume.far_corners[3] = center_far - (right * far_width * 0.5f) - (up * far_height * 0.5f);
+
+    //planes for culling, each side goes through two near corners and the matching far corner
+    Vector3 inside_point = (center_near + center_far) * 0.5f;
+    Vector3 plane_points[6][3] = {
+        {viewing_volume.close_corners[0], viewing_volume.close_corners[1], viewing_volume.close_corners[2]},
+        {viewing_volume.far_corners[0], viewing_volume.far_corners[1], viewing_volume.far_corners[2]},
+        {viewing_volume.close_corners[0], viewing_volume.close_corners[1], viewing_volume.far_corners[1]},
+        {viewing_volume.close_corners[1], viewing_volume.close_corners[2], viewing_volume.far_corners[2]},
+        {viewing_volume.close_corners[2], viewing_volume.close_corners[3], viewing_volume.far_corners[3]},
+        {viewing_volume.close_corners[3], viewing_volume.close_corners[0], viewing_volume.far_corners[0]}
+    };
+    for (int i = 0; i < 6; i++) {
+        Vector3 normal = normalize(cross_product(plane_points[i][1] - plane_points[i][0], plane_points[i][2] - plane_points[i][0]));
+        float distance = -dot_product(normal, plane_points[i][0]);
+        //winding differs per plane, flip whichever ones ended up facing out
+        if (dot_product(normal, inside_point) + distance < 0.0f) {
+            normal = -normal;
+            distance = -distance;
+        }
+        viewing_volume.plane_normals[i] = normal;
+        viewing_volume.plane_distances[i] = distance;
+    }
+}
+
+bool Frustum::intersects_box(const Vector3& bounds_min, const Vector3& bounds_max) const {
+    for (int i = 0; i < 6; i++) {
+        //the box corner furthest along the plane normal, if even that one is behind the plane the whole box is
+        const Vector3& normal = plane_normals[i];
+        Vector3 furthest(
+            normal.x >= 0.0f ? bounds_max.x : bounds_min.x,
+            normal.y >= 0.0f ? bounds_max.y : bounds_min.y,
+            normal.z >= 0.0f ? bounds_max.z : bounds_min.z
+        );
+        if (dot_product(normal, furthest) + plane_distances[i] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Ray Camera::get_ray(float ndc_x, float ndc_y) const {
+    //inverse of what the view and projection matrices do to a point, w ends up as -depth * 2fn/(f-n)
+    //so the divide mirrors the image, the ray has to follow that same flip to line up with rasterized frames
+    float tan_half_fov = tanf(fov / 2.0f);
+    float w_scale = 2.0f * far_plane * near_plane / (far_plane - near_plane);
+    Vector3 direction = forward
+        + right * (-ndc_x * aspect_ratio * tan_half_fov * w_scale)
+        + up * (-ndc_y * tan_half_fov * w_scale);
+    return Ray{position, normalize(direction)};
+}
+
+bool Frustum::intersects_sphere(const Vector3& center, float radius) const {
+    for (int i = 0; i < 6; i++) {
+        if (dot_product(plane_normals[i], center) + plane_distances[i] < -radius) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void Camera::update_views() {
+    revision = next_revision();
     set_view_matrix();
     set_projection_matrix();
     define_viewing_volume();
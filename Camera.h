@@ -8,6 +8,12 @@
 struct Frustum{
     Vector3 far_corners[4];
     Vector3 close_corners[4];
+    //near, far, then the four sides, normals point into the volume
+    Vector3 plane_normals[6];
+    float plane_distances[6];
+
+    bool intersects_box(const Vector3& bounds_min, const Vector3& bounds_max) const;
+    bool intersects_sphere(const Vector3& center, float radius) const;
 };
 
 class Camera {
@@ -23,6 +29,7 @@ private:
     float near_plane;     
     float far_plane;   
     Frustum viewing_volume;   
+    uint64_t revision = next_revision(); //bumped whenever anything above changes
 
 public:
     Camera();
@@ -39,11 +46,13 @@ public:
     float get_near_plane() const { return near_plane; }
     float get_far_plane() const { return far_plane; }
     Frustum get_viewing_volume() const{return viewing_volume;}
+    Ray get_ray(float ndc_x, float ndc_y) const;
+    uint64_t get_revision() const { return revision; }
 
-    void set_position(const Vector3& new_position) { position = new_position; }
-    void set_forward(const Vector3& new_forward) { forward = new_forward; }
-    void set_up(const Vector3& new_up) { up = new_up; }
-    void set_right(const Vector3& new_right) { right = new_right; }
+    void set_position(const Vector3& new_position) { position = new_position; revision = next_revision(); }
+    void set_forward(const Vector3& new_forward) { forward = new_forward; revision = next_revision(); }
+    void set_up(const Vector3& new_up) { up = new_up; revision = next_revision(); }
+    void set_right(const Vector3& new_right) { right = new_right; revision = next_revision(); }
 
     void define_viewing_volume(); 
     void set_view_matrix();
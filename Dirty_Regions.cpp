@@ -0,0 +1,176 @@
+#include "Dirty_Regions.h"
+#include "Rasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Pixel_Rect get_model_screen_rect(const Model& model, const Camera& camera, const Matrix4& all_transforms, int width, int height) {
+    Pixel_Rect full_screen{0, 0, width - 1, height - 1};
+    const std::vector<Vector3>& vertices = model.get_vertices();
+    if (model.get_meshlets().empty() || (vertices.empty() && model.has_vertex_streams())) {
+        return Pixel_Rect();
+    }
+    //the meshlet spheres behind get_bounds are loose enough to dirty half the screen for a small model, a pass over
+    //the vertices is far tighter and only happens for models that changed, which get redrawn anyway.
+    //a released model has no vertices left, the spheres are all there is
+    Vector3 bounds_min, bounds_max;
+    if (!model.has_vertex_streams()) {
+        model.get_bounds(bounds_min, bounds_max);
+    } else {
+        bounds_min = vertices[0];
+        bounds_max = vertices[0];
+    }
+    for (const Vector3& vertex : vertices) {
+        bounds_min = Vector3(std::min(bounds_min.x, vertex.x), std::min(bounds_min.y, vertex.y), std::min(bounds_min.z, vertex.z));
+        bounds_max = Vector3(std::max(bounds_max.x, vertex.x), std::max(bounds_max.y, vertex.y), std::max(bounds_max.z, vertex.z));
+    }
+    if (!camera.get_viewing_volume().intersects_box(bounds_min, bounds_max)) {
+        return Pixel_Rect();
+    }
+
+    float min_x = std::numeric_limits<float>::max(), min_y = std::numeric_limits<float>::max();
+    float max_x = -std::numeric_limits<float>::max(), max_y = -std::numeric_limits<float>::max();
+    for (int corner = 0; corner < 8; ++corner) {
+        Vector3 world_corner(
+            corner & 1 ? bounds_max.x : bounds_min.x,
+            corner & 2 ? bounds_max.y : bounds_min.y,
+            corner & 4 ? bounds_max.z : bounds_min.z
+        );
+        if (dot_product(camera.get_forward(), world_corner - camera.get_position()) <= camera.get_near_plane()) {
+            return full_screen;
+        }
+        Vector3 screen_corner = project_to_screen(world_corner, all_transforms, width, height);
+        min_x = std::min(min_x, screen_corner.x);
+        min_y = std::min(min_y, screen_corner.y);
+        max_x = std::max(max_x, screen_corner.x);
+        max_y = std::max(max_y, screen_corner.y);
+    }
+    //same projection the rasterizer uses, so the box holds every pixel the model can touch
+    return Pixel_Rect{
+        std::max(0, static_cast<int>(std::floor(min_x)) - 1),
+        std::max(0, static_cast<int>(std::floor(min_y)) - 1),
+        std::min(width - 1, static_cast<int>(std::ceil(max_x)) + 1),
+        std::min(height - 1, static_cast<int>(std::ceil(max_y)) + 1)
+    };
+}
+
+void Dirty_Regions::mark(const Pixel_Rect& rect) {
+    if (rect.is_empty()) {
+        return;
+    }
+    int start_x = std::max(0, rect.min_x / DIRTY_TILE_SIZE);
+    int start_y = std::max(0, rect.min_y / DIRTY_TILE_SIZE);
+    int end_x = std::min(tiles_x - 1, rect.max_x / DIRTY_TILE_SIZE);
+    int end_y = std::min(tiles_y - 1, rect.max_y / DIRTY_TILE_SIZE);
+    for (int y = start_y; y <= end_y; ++y) {
+        std::fill(dirty_tiles.begin() + y * tiles_x + start_x, dirty_tiles.begin() + y * tiles_x + end_x + 1, 1);
+    }
+}
+
+template<typename Tile_Test>
+void Dirty_Regions::collect_rects(Tile_Test is_marked, std::vector<Pixel_Rect>& rects) const {
+    //each row of tiles becomes runs, a run lines up exactly with one from the row above just makes that rect taller
+    rects.clear();
+    for (int tile_y = 0; tile_y < tiles_y; ++tile_y) {
+        int tile_x = 0;
+        while (tile_x < tiles_x) {
+            if (!is_marked(tile_y * tiles_x + tile_x)) {
+                tile_x++;
+                continue;
+            }
+            int run_start = tile_x;
+            while (tile_x < tiles_x && is_marked(tile_y * tiles_x + tile_x)) {
+                tile_x++;
+            }
+            Pixel_Rect run{
+                run_start * DIRTY_TILE_SIZE,
+                tile_y * DIRTY_TILE_SIZE,
+                std::min(width - 1, tile_x * DIRTY_TILE_SIZE - 1),
+                std::min(height - 1, (tile_y + 1) * DIRTY_TILE_SIZE - 1)
+            };
+            auto above = std::find_if(rects.begin(), rects.end(), [&](const Pixel_Rect& rect) {
+                return rect.min_x == run.min_x && rect.max_x == run.max_x && rect.max_y == run.min_y - 1;
+            });
+            if (above != rects.end()) {
+                above->max_y = run.max_y;
+            } else {
+                rects.push_back(run);
+            }
+        }
+    }
+}
+
+void Dirty_Regions::build_rects() {
+    collect_rects([&](int tile) { return dirty_tiles[tile] != 0; }, dirty_rects);
+    if (!dirty_rects.empty()) {
+        frame_revision = next_revision();
+        for (size_t tile = 0; tile < dirty_tiles.size(); ++tile) {
+            if (dirty_tiles[tile]) {
+                tile_revisions[tile] = frame_revision;
+            }
+        }
+    }
+    std::fill(dirty_tiles.begin(), dirty_tiles.end(), 0);
+}
+
+void Dirty_Regions::get_rects_changed_since(uint64_t revision, std::vector<Pixel_Rect>& rects) const {
+    collect_rects([&](int tile) { return tile_revisions[tile] > revision; }, rects);
+}
+
+const std::vector<Pixel_Rect>& Dirty_Regions::update(const Camera& camera, int new_width, int new_height, const std::vector<Model*>& models) {
+    if (new_width != width || new_height != height) {
+        width = new_width;
+        height = new_height;
+        tiles_x = (width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+        tiles_y = (height + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+        dirty_tiles.assign(tiles_x * tiles_y, 0);
+        tile_revisions.assign(tiles_x * tiles_y, 0);
+        everything_dirty = true;
+    }
+    if (camera.get_revision() != camera_revision) {
+        camera_revision = camera.get_revision();
+        everything_dirty = true;  //every model moves on screen
+    }
+    if (models.size() != tracked_models.size()) {
+        tracked_models.resize(models.size());
+        everything_dirty = true;
+    }
+
+    Matrix4 all_transforms = camera.get_projection_matrix() * camera.get_view_matrix();
+    for (size_t i = 0; i < models.size(); ++i) {
+        Tracked_Model& tracked = tracked_models[i];
+        const Model& model = *models[i];
+        if (!everything_dirty && tracked.model == &model && tracked.revision == model.get_revision()) {
+            continue;
+        }
+        //a changed model has to be wiped from where it was as well as drawn where it is now
+        Pixel_Rect screen_rect = get_model_screen_rect(model, camera, all_transforms, width, height);
+        if (!everything_dirty) {
+            mark(tracked.screen_rect);
+            mark(screen_rect);
+        }
+        tracked.model = &model;
+        tracked.revision = model.get_revision();
+        tracked.screen_rect = screen_rect;
+    }
+
+    if (everything_dirty) {
+        dirty_rects.clear();
+        dirty_rects.push_back(Pixel_Rect{0, 0, width - 1, height - 1});
+        std::fill(dirty_tiles.begin(), dirty_tiles.end(), 0);
+        frame_revision = next_revision();
+        std::fill(tile_revisions.begin(), tile_revisions.end(), frame_revision);
+        everything_dirty = false;
+    } else {
+        build_rects();
+    }
+    return dirty_rects;
+}
+
+int Dirty_Regions::get_dirty_pixel_count() const {
+    int count = 0;
+    for (const Pixel_Rect& rect : dirty_rects) {
+        count += (rect.max_x - rect.min_x + 1) * (rect.max_y - rect.min_y + 1);
+    }
+    return count;
+}
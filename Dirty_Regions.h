@@ -0,0 +1,70 @@
+/*
+File Description:
+- Change tracking for a frame buffer that is kept between frames. Every model
+- and the camera carry a revision stamp, this remembers the stamps and the
+- screen rect each model covered when the frame was last drawn. Next frame
+- only the tiles under a changed model, where it was and where it is now, are
+- handed back to be cleared and drawn again. A camera move, a resize or a
+- different set of models dirties everything, a scene where nothing changed
+- comes back with no work at all.
+- Every tile also keeps the revision it was last redrawn at, so a copy of the
+- frame taken at some revision can be brought up to date tile by tile.
+*/
+
+#ifndef DIRTY_REGIONS_H
+#define DIRTY_REGIONS_H
+//Standard C Libraries
+#include <vector>   //tile flags, tracked models
+#include <cstdint>  //revision stamps
+//Created Files
+#include "Camera.h"
+#include "Model.h"
+#include "Frame_Buffer.h"
+
+const int DIRTY_TILE_SIZE = 32; //pixels per side, small enough to hug a moving object without tracking many tiles
+
+//screen rect a model's bounds cover from this camera, grown by a pixel for rounding. empty when it is out of view,
+//the whole screen when the bounds reach behind the near plane and the projection cannot be trusted
+Pixel_Rect get_model_screen_rect(const Model& model, const Camera& camera, const Matrix4& all_transforms, int width, int height);
+
+class Dirty_Regions {
+    private:
+        struct Tracked_Model {
+            const Model* model = nullptr;
+            uint64_t revision = 0;
+            Pixel_Rect screen_rect;  //where it was drawn
+        };
+
+        int width = 0;
+        int height = 0;
+        int tiles_x = 0;
+        int tiles_y = 0;
+        std::vector<uint8_t> dirty_tiles;
+        std::vector<uint64_t> tile_revisions;  //when each tile was last handed out to be redrawn
+        uint64_t frame_revision = 0;           //newest of those, what the frame as a whole is at
+        std::vector<Pixel_Rect> dirty_rects;   //handed out by update, tiles merged into as few rects as is easy
+        std::vector<Tracked_Model> tracked_models;
+        uint64_t camera_revision = 0;
+        bool everything_dirty = true;
+
+        void mark(const Pixel_Rect& rect);
+        template<typename Tile_Test>
+        void collect_rects(Tile_Test is_marked, std::vector<Pixel_Rect>& rects) const;
+        void build_rects();
+
+    public:
+        void invalidate() { everything_dirty = true; } //for changes it cannot see, like new lighting or the buffer being thrown away
+
+        //compares the scene with what was drawn last time and returns the rects that have to be cleared and drawn again,
+        //they never overlap and come back empty when nothing changed. the models are then considered drawn as they are now
+        const std::vector<Pixel_Rect>& update(const Camera& camera, int width, int height, const std::vector<Model*>& models);
+        //where the model at this index in the last update's list is on screen
+        const Pixel_Rect& get_screen_rect(size_t model_index) const { return tracked_models[model_index].screen_rect; }
+        int get_dirty_pixel_count() const;
+
+        uint64_t get_frame_revision() const { return frame_revision; }
+        //tiles redrawn after the frame was at this revision, all of them for 0 or a revision from before a resize
+        void get_rects_changed_since(uint64_t revision, std::vector<Pixel_Rect>& rects) const;
+};
+
+#endif
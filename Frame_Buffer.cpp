@@ -0,0 +1,140 @@
+#include "Frame_Buffer.h"
+#include <algorithm>
+
+uint32_t pack_color(const Color& color) {
+    //clamp first, lighting can push channels past 1
+    uint32_t r = static_cast<uint32_t>(std::min(1.0f, std::max(0.0f, color.r)) * 255.0f);
+    uint32_t g = static_cast<uint32_t>(std::min(1.0f, std::max(0.0f, color.g)) * 255.0f);
+    uint32_t b = static_cast<uint32_t>(std::min(1.0f, std::max(0.0f, color.b)) * 255.0f);
+    uint32_t a = static_cast<uint32_t>(std::min(1.0f, std::max(0.0f, color.a)) * 255.0f);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+Color unpack_color(uint32_t packed) {
+    return Color{
+        ((packed >> 16) & 0xFF) / 255.0f,
+        ((packed >> 8) & 0xFF) / 255.0f,
+        (packed & 0xFF) / 255.0f,
+        (packed >> 24) / 255.0f
+    };
+}
+
+void Frame_Buffer::resize(int new_width, int new_height) {
+    if (new_width == width && new_height == height) {
+        return;
+    }
+    width = new_width;
+    height = new_height;
+    //assign keeps the old capacity around, so scaling back up after a drop does not reallocate
+    color.assign(width * height, 0);
+    depth.assign(width * height, std::numeric_limits<float>::max());
+    has_translucency = false;
+    translucency_rects.clear();
+}
+
+void Frame_Buffer::clear(uint32_t clear_color) {
+    std::fill(color.begin(), color.end(), clear_color);
+    std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+    has_translucency = false;  //anything never resolved is dropped with the rest of the frame
+    translucency_rects.clear();
+}
+
+void Frame_Buffer::clear_rect(uint32_t clear_color, const Pixel_Rect& rect) {
+    int min_x = std::max(0, rect.min_x);
+    int max_x = std::min(width - 1, rect.max_x);
+    if (min_x > max_x) {
+        return;
+    }
+    for (int y = std::max(0, rect.min_y); y <= std::min(height - 1, rect.max_y); ++y) {
+        std::fill(color.begin() + y * width + min_x, color.begin() + y * width + max_x + 1, clear_color);
+        std::fill(depth.begin() + y * width + min_x, depth.begin() + y * width + max_x + 1, std::numeric_limits<float>::max());
+    }
+}
+
+void Frame_Buffer::copy_color_rect(std::vector<uint32_t>& target, const Pixel_Rect& rect) const {
+    int min_x = std::max(0, rect.min_x);
+    int max_x = std::min(width - 1, rect.max_x);
+    if (min_x > max_x) {
+        return;
+    }
+    for (int y = std::max(0, rect.min_y); y <= std::min(height - 1, rect.max_y); ++y) {
+        std::copy(color.begin() + y * width + min_x, color.begin() + y * width + max_x + 1, target.begin() + y * width + min_x);
+    }
+}
+
+void Frame_Buffer::set_scissor_rects(const std::vector<Pixel_Rect>& rects) {
+    scissor_rects.assign(rects.begin(), rects.end());
+    scissor = Pixel_Rect();
+    for (const Pixel_Rect& rect : rects) {
+        scissor = scissor.is_empty() ? rect : Pixel_Rect{
+            std::min(scissor.min_x, rect.min_x), std::min(scissor.min_y, rect.min_y),
+            std::max(scissor.max_x, rect.max_x), std::max(scissor.max_y, rect.max_y)
+        };
+    }
+    scissor.min_x = std::max(0, scissor.min_x);
+    scissor.min_y = std::max(0, scissor.min_y);
+}
+
+void Frame_Buffer::begin_translucency_rects(const std::vector<Pixel_Rect>& rects) {
+    //sized once, whatever sits outside the rects is never read
+    accumulation.resize(width * height);
+    revealage.resize(width * height);
+    for (const Pixel_Rect& rect : rects) {
+        int min_x = std::max(0, rect.min_x);
+        int max_x = std::min(width - 1, rect.max_x);
+        for (int y = std::max(0, rect.min_y); min_x <= max_x && y <= std::min(height - 1, rect.max_y); ++y) {
+            std::fill(accumulation.begin() + y * width + min_x, accumulation.begin() + y * width + max_x + 1, Color{0.0f, 0.0f, 0.0f, 0.0f});
+            std::fill(revealage.begin() + y * width + min_x, revealage.begin() + y * width + max_x + 1, 1.0f);
+        }
+    }
+    translucency_rects.assign(rects.begin(), rects.end());
+    has_translucency = true;
+}
+
+void Frame_Buffer::begin_translucency(float depth_near, float depth_far) {
+    translucency_depth_near = depth_near;
+    translucency_depth_far = depth_far;
+    if (has_translucency) {
+        return;
+    }
+    //first translucent draw since the last resolve, start from nothing accumulated and everything revealed
+    has_translucency = true;
+    translucency_rects.clear();
+    accumulation.assign(width * height, Color{0.0f, 0.0f, 0.0f, 0.0f});
+    revealage.assign(width * height, 1.0f);
+}
+
+void Frame_Buffer::resolve_translucency() {
+    if (!has_translucency) {
+        return;
+    }
+    auto resolve_span = [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            if (revealage[i] >= 1.0f) {
+                continue;
+            }
+            const Color& sum = accumulation[i];
+            float inverse_weight = 1.0f / std::min(5e4f, std::max(1e-4f, sum.a));
+            float coverage = 1.0f - revealage[i];
+            Color background = unpack_color(color[i]);
+            color[i] = pack_color(Color{
+                sum.r * inverse_weight * coverage + background.r * revealage[i],
+                sum.g * inverse_weight * coverage + background.g * revealage[i],
+                sum.b * inverse_weight * coverage + background.b * revealage[i],
+                1.0f
+            });
+        }
+    };
+    if (translucency_rects.empty()) {
+        resolve_span(0, width * height);
+    }
+    for (const Pixel_Rect& rect : translucency_rects) {
+        int min_x = std::max(0, rect.min_x);
+        int max_x = std::min(width - 1, rect.max_x);
+        for (int y = std::max(0, rect.min_y); min_x <= max_x && y <= std::min(height - 1, rect.max_y); ++y) {
+            resolve_span(y * width + min_x, y * width + max_x + 1);
+        }
+    }
+    has_translucency = false;
+    translucency_rects.clear();
+}
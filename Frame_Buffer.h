@@ -0,0 +1,99 @@
+/*
+File Description:
+- A CPU side render target, holds the color and depth values for every pixel
+- of the internal render resolution. Rasterizing happens here and the Screen
+- uploads the finished color buffer to the window when presenting, so the
+- render resolution does not have to match the window size.
+- Translucent faces go into separate accumulation and revealage buffers and
+- get blended over the color buffer once the frame is done, so they can be
+- drawn in any order.
+- A scissor rect limits rasterizing to part of the buffer, so a frame that only
+- changed in a few places can be patched instead of redrawn. It can also be a
+- set of separate rects, so one pass over a model patches all of them.
+Important References:
+- https://jcgt.org/published/0002/02/09/ (weighted blended order independent transparency)
+*/
+
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+//Standard C Libraries
+#include <vector>   //pixel storage
+#include <cstdint>  //fixed width pixel type
+#include <limits>   //clear value for depth
+#include <algorithm> //weight clamps
+//Created Files
+#include "Utilities.h"
+
+uint32_t pack_color(const Color& color); //packs a 0-1 float color into ARGB8888
+//top byte of every finished pixel, lighting scales the alpha along with the color so the opaque writes force it back to solid
+const uint32_t OPAQUE_ALPHA = 0xFF000000;
+Color unpack_color(uint32_t packed);
+
+//pixel bounds, both ends inclusive, empty when a min is past its max
+struct Pixel_Rect {
+    int min_x = 0;
+    int min_y = 0;
+    int max_x = -1;
+    int max_y = -1;
+
+    bool is_empty() const { return min_x > max_x || min_y > max_y; }
+    bool intersects(const Pixel_Rect& other) const {
+        return !is_empty() && !other.is_empty() && min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+    }
+};
+
+struct Frame_Buffer {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> color; //row major, ARGB8888
+    std::vector<float> depth;    //row major, smaller is closer
+
+    //weighted blended translucency, only sized and cleared in frames that actually draw something translucent
+    std::vector<Color> accumulation; //premultiplied color times weight, alpha holds alpha times weight
+    std::vector<float> revealage;    //how much of the opaque color still shows through
+    bool has_translucency = false;
+    float translucency_depth_near = 0.0f;  //depth values at the camera's near and far planes, for the weights
+    float translucency_depth_far = 1.0f;
+
+    //rasterizing only touches pixels inside this, the defaults never cut anything the buffer edges would not already
+    Pixel_Rect scissor = Pixel_Rect{0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    //when not empty the scissor is just their bounding box and only pixels inside one of these get written, they must not overlap
+    std::vector<Pixel_Rect> scissor_rects;
+    std::vector<Pixel_Rect> translucency_rects;  //what the current translucent pass covers, empty for the whole buffer
+
+    void resize(int new_width, int new_height);
+    void clear(uint32_t clear_color);
+    void clear_rect(uint32_t clear_color, const Pixel_Rect& rect); //clear() for just part of the buffer
+    void copy_color_rect(std::vector<uint32_t>& target, const Pixel_Rect& rect) const; //target has to be the same size as color
+    void set_scissor(const Pixel_Rect& rect) {
+        scissor = Pixel_Rect{std::max(0, rect.min_x), std::max(0, rect.min_y), rect.max_x, rect.max_y};
+        scissor_rects.clear();
+    }
+    void set_scissor_rects(const std::vector<Pixel_Rect>& rects);
+    void reset_scissor() {
+        scissor = Pixel_Rect{0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+        scissor_rects.clear();
+    }
+
+    float& depth_at(int x, int y) { return depth[y * width + x]; }
+    void set_pixel(int x, int y, const Color& pixel_color) { color[y * width + x] = pack_color(pixel_color); }
+
+    void begin_translucency(float depth_near, float depth_far);
+    //starts a translucent pass over just these rects, only they get reset and resolved. the draws have to stay inside them
+    void begin_translucency_rects(const std::vector<Pixel_Rect>& rects);
+    void accumulate_translucent(int x, int y, float z, const Color& fragment_color, float alpha) {
+        //closer fragments get a bigger weight so they win over what is behind them without any sorting
+        float normalized_depth = std::min(1.0f, std::max(0.0f, (z - translucency_depth_near) / (translucency_depth_far - translucency_depth_near)));
+        float distance_falloff = 1.0f - normalized_depth;
+        float weight = alpha * std::max(1e-2f, 3e3f * distance_falloff * distance_falloff * distance_falloff);
+        Color& sum = accumulation[y * width + x];
+        sum.r += fragment_color.r * alpha * weight;
+        sum.g += fragment_color.g * alpha * weight;
+        sum.b += fragment_color.b * alpha * weight;
+        sum.a += alpha * weight;
+        revealage[y * width + x] *= 1.0f - alpha;
+    }
+    void resolve_translucency(); //blends everything accumulated over the opaque color
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "Frame_Capture.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <array>
+
+namespace {
+    uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+        //built once on first use, static init is thread safe so several encoders can share it
+        static const std::array<uint32_t, 256> crc_table = [] {
+            std::array<uint32_t, 256> table;
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            return table;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < length; ++i) {
+            crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void append_big_endian(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void write_chunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> chunk;
+        chunk.reserve(data.size() + 12);
+        append_big_endian(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        //the crc covers the type and data, not the length
+        append_big_endian(chunk, crc32(chunk.data() + 4, data.size() + 4));
+        file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+    }
+
+    void argb_to_rgb(const std::vector<uint32_t>& pixels, std::vector<uint8_t>& rgb) {
+        rgb.resize(pixels.size() * 3);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            rgb[i * 3 + 0] = static_cast<uint8_t>(pixels[i] >> 16);
+            rgb[i * 3 + 1] = static_cast<uint8_t>(pixels[i] >> 8);
+            rgb[i * 3 + 2] = static_cast<uint8_t>(pixels[i]);
+        }
+    }
+}
+
+bool write_ppm(const std::string& file_path, const uint8_t* rgb, int width, int height) {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb), static_cast<size_t>(width) * height * 3);
+    return file.good();
+}
+
+bool write_png(const std::string& file_path, const uint8_t* rgb, int width, int height) {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    append_big_endian(header, width);
+    append_big_endian(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});  //8 bit depth, truecolor, deflate, standard filters, no interlace
+    write_chunk(file, "IHDR", header);
+
+    //zlib stream made of stored deflate blocks, no compression but no zlib dependency and next to no encoder time
+    size_t row_size = static_cast<size_t>(width) * 3 + 1;
+    size_t raw_size = row_size * height;
+    std::vector<uint8_t> raw;
+    raw.reserve(raw_size);
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);  //filter type none
+        raw.insert(raw.end(), rgb + static_cast<size_t>(y) * width * 3, rgb + static_cast<size_t>(y + 1) * width * 3);
+    }
+
+    std::vector<uint8_t> compressed;
+    compressed.reserve(raw_size + raw_size / 65535 * 5 + 16);
+    compressed.push_back(0x78);
+    compressed.push_back(0x01);
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t offset = 0; offset < raw_size || offset == 0; ) {
+        size_t block_size = std::min<size_t>(65535, raw_size - offset);
+        bool last = offset + block_size >= raw_size;
+        compressed.push_back(last ? 1 : 0);
+        compressed.push_back(static_cast<uint8_t>(block_size));
+        compressed.push_back(static_cast<uint8_t>(block_size >> 8));
+        compressed.push_back(static_cast<uint8_t>(~block_size));
+        compressed.push_back(static_cast<uint8_t>(~block_size >> 8));
+        for (size_t i = offset; i < offset + block_size; ++i) {
+            adler_a = (adler_a + raw[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        compressed.insert(compressed.end(), raw.begin() + offset, raw.begin() + offset + block_size);
+        offset += block_size;
+        if (last) {
+            break;
+        }
+    }
+    append_big_endian(compressed, (adler_b << 16) | adler_a);
+    write_chunk(file, "IDAT", compressed);
+    write_chunk(file, "IEND", std::vector<uint8_t>());
+    return file.good();
+}
+
+//-------------------------------------Frame_Capture----------------------------------------------
+Frame_Capture::Frame_Capture(Capture_Format format, const std::string& output_path, size_t queue_capacity, Queue_Full_Policy policy)
+    : format(format), policy(policy), output_path(output_path), queue_capacity(std::max<size_t>(1, queue_capacity)),
+      stopping(false), pipe(nullptr), pipe_width(0), pipe_height(0), submitted_count(0), dropped_count(0), written_count(0) {
+    if (format == Capture_Format::RAW_PIPE) {
+        pipe = popen(output_path.c_str(), "w");
+        if (!pipe) {
+            std::cerr << "Failed to start capture pipe: " << output_path << std::endl;
+        }
+    }
+    encoder = std::thread(&Frame_Capture::encode_loop, this);
+}
+
+Frame_Capture::~Frame_Capture() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    frame_queued.notify_all();
+    encoder.join();
+    if (pipe) {
+        pclose(pipe);
+    }
+}
+
+bool Frame_Capture::submit(std::vector<uint32_t>& pixels, int width, int height, uint64_t* contents_revision) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    submitted_count++;
+    if (queued_frames.size() >= queue_capacity) {
+        if (policy == Queue_Full_Policy::DROP) {
+            dropped_count++;
+            return false;
+        }
+        slot_freed.wait(lock, [this] { return queued_frames.size() < queue_capacity; });
+    }
+
+    //hand the finished frame over by swapping buffers, the render thread gets a recycled one back to draw the next frame into
+    Captured_Frame frame;
+    uint64_t recycled_revision = 0;
+    if (!free_buffers.empty()) {
+        frame.pixels = std::move(free_buffers.back().pixels);
+        recycled_revision = free_buffers.back().contents_revision;
+        free_buffers.pop_back();
+    }
+    frame.pixels.swap(pixels);
+    frame.width = width;
+    frame.height = height;
+    frame.frame_number = submitted_count - 1;
+    frame.contents_revision = contents_revision ? *contents_revision : 0;
+    if (contents_revision) {
+        *contents_revision = recycled_revision;
+    }
+    queued_frames.push_back(std::move(frame));
+    lock.unlock();
+    frame_queued.notify_one();
+    return true;
+}
+
+void Frame_Capture::encode_loop() {
+    std::vector<uint8_t> rgb;
+    while (true) {
+        Captured_Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            frame_queued.wait(lock, [this] { return stopping || !queued_frames.empty(); });
+            if (queued_frames.empty()) {
+                return;  //stopping and drained
+            }
+            frame = std::move(queued_frames.front());
+            queued_frames.pop_front();
+        }
+
+        write_frame(frame, rgb);
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            written_count++;
+            free_buffers.push_back(std::move(frame));
+        }
+        slot_freed.notify_one();
+    }
+}
+
+void Frame_Capture::write_frame(const Captured_Frame& frame, std::vector<uint8_t>& rgb) {
+    argb_to_rgb(frame.pixels, rgb);
+    if (format == Capture_Format::RAW_PIPE) {
+        if (!pipe) {
+            return;
+        }
+        //a raw stream has no per frame header, the encoder on the other end only knows the first size it was given
+        if (pipe_width == 0) {
+            pipe_width = frame.width;
+            pipe_height = frame.height;
+            std::cout << "Capture pipe frames are " << pipe_width << "x" << pipe_height << " rgb24" << std::endl;
+        }
+        if (frame.width != pipe_width || frame.height != pipe_height) {
+            std::cerr << "Capture frame " << frame.frame_number << " changed size, skipped for the pipe" << std::endl;
+            return;
+        }
+        fwrite(rgb.data(), 1, rgb.size(), pipe);
+        return;
+    }
+
+    std::string number = std::to_string(frame.frame_number);
+    number.insert(0, number.size() < 6 ? 6 - number.size() : 0, '0');
+    std::string file_path = output_path + "_" + number + (format == Capture_Format::PNG ? ".png" : ".ppm");
+    bool written = format == Capture_Format::PNG
+        ? write_png(file_path, rgb.data(), frame.width, frame.height)
+        : write_ppm(file_path, rgb.data(), frame.width, frame.height);
+    if (!written) {
+        std::cerr << "Failed to write capture frame: " << file_path << std::endl;
+    }
+}
@@ -0,0 +1,92 @@
+/*
+File Description:
+- Records rendered frames without slowing the frame loop down. Finished color
+- buffers are swapped (not copied) into a bounded queue and a background
+- encoder thread writes them out as a PPM or PNG image sequence, or streams
+- raw RGB frames into a pipe for an external encoder such as ffmpeg.
+- When the queue is full a frame is either dropped or the caller waits,
+- depending on the policy it was created with.
+
+Important References:
+- https://netpbm.sourceforge.net/doc/ppm.html
+- https://www.w3.org/TR/png/
+*/
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+//Standard C Libraries
+#include <vector>             //pixel buffers
+#include <deque>              //queued frames
+#include <string>             //output paths
+#include <cstdint>            //pixel type
+#include <cstdio>             //pipe output
+#include <thread>             //encoder
+#include <mutex>              //guards the queue
+#include <condition_variable> //wakes encoder and blocked submitters
+#include <atomic>             //counters read from the render thread
+
+enum class Capture_Format {
+    PPM,
+    PNG,
+    RAW_PIPE  //output path is a shell command that reads width*height*3 byte RGB frames from stdin
+};
+
+enum class Queue_Full_Policy {
+    DROP,   //skip the frame, the frame loop never waits
+    BLOCK   //wait for the encoder, every frame gets recorded
+};
+
+class Frame_Capture {
+    private:
+        struct Captured_Frame {
+            std::vector<uint32_t> pixels;
+            int width;
+            int height;
+            uint64_t frame_number;
+            uint64_t contents_revision;  //whatever tag the submitter gave these pixels, 0 for none
+        };
+
+        Capture_Format format;
+        Queue_Full_Policy policy;
+        std::string output_path;
+        size_t queue_capacity;
+
+        std::deque<Captured_Frame> queued_frames;
+        std::vector<Captured_Frame> free_buffers;  //written frames come back here to be swapped out again
+        std::mutex queue_mutex;
+        std::condition_variable frame_queued;
+        std::condition_variable slot_freed;
+        bool stopping;
+        std::thread encoder;
+
+        FILE* pipe;
+        int pipe_width;
+        int pipe_height;
+        std::atomic<uint64_t> submitted_count;
+        std::atomic<uint64_t> dropped_count;
+        std::atomic<uint64_t> written_count;
+
+        void encode_loop();
+        void write_frame(const Captured_Frame& frame, std::vector<uint8_t>& rgb);
+
+    public:
+        Frame_Capture(Capture_Format format, const std::string& output_path, size_t queue_capacity = 4,
+                      Queue_Full_Policy policy = Queue_Full_Policy::DROP);
+        ~Frame_Capture();  //finishes writing everything already queued
+        Frame_Capture(const Frame_Capture&) = delete;
+        Frame_Capture& operator=(const Frame_Capture&) = delete;
+
+        //takes the contents of pixels and leaves an old, same sized buffer (or an empty one) in its place, returns false if dropped.
+        //contents_revision tags what pixels holds, and comes back as the tag of the buffer handed out (0 for an empty one),
+        //so a caller that keeps its frame can tell how out of date the recycled buffer is
+        bool submit(std::vector<uint32_t>& pixels, int width, int height, uint64_t* contents_revision = nullptr);
+
+        uint64_t get_submitted_count() const { return submitted_count; }
+        uint64_t get_dropped_count() const { return dropped_count; }
+        uint64_t get_written_count() const { return written_count; }
+};
+
+bool write_ppm(const std::string& file_path, const uint8_t* rgb, int width, int height);
+bool write_png(const std::string& file_path, const uint8_t* rgb, int width, int height);
+
+#endif
@@ -1,5 +1,105 @@
 
 #include "Loader.h"
+#include "Streamed_Mesh.h"
+#include "Arena.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace {
+    //read only view of a whole file, lets the chunk builder index vertex data that lives on disk
+    struct Mapped_File {
+        void* data = MAP_FAILED;
+        size_t size = 0;
+
+        bool open(const std::string& path, size_t expected_size) {
+            size = expected_size;
+            if (size == 0) {
+                return true;
+            }
+            int file_descriptor = ::open(path.c_str(), O_RDONLY);
+            if (file_descriptor == -1) {
+                return false;
+            }
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            ::close(file_descriptor);  //the mapping keeps the file alive on its own
+            return data != MAP_FAILED;
+        }
+        ~Mapped_File() {
+            if (data != MAP_FAILED) {
+                munmap(data, size);
+            }
+        }
+        const Vector3* as_vectors() const { return static_cast<const Vector3*>(data); }
+    };
+
+    const size_t CELL_FLUSH_SIZE = 1024; //triangles buffered per cell before they are appended to its temp file
+    const size_t LOAD_ARENA_BLOCK_SIZE = 16 * 1024; //plenty for the corner lists of one face line
+
+    //walks one OBJ line word by word without copying it into a stream first
+    struct Line_Reader {
+        const char* position;
+
+        explicit Line_Reader(const std::string& line) : position(line.c_str()) {}
+
+        void skip_spaces() {
+            while (*position == ' ' || *position == '\t' || *position == '\r') {
+                position++;
+            }
+        }
+        //the next word, empty once the line runs out
+        std::pair<const char*, size_t> read_token() {
+            skip_spaces();
+            const char* start = position;
+            while (*position != '\0' && *position != ' ' && *position != '\t' && *position != '\r') {
+                position++;
+            }
+            return {start, static_cast<size_t>(position - start)};
+        }
+        bool read_float(float& value) {
+            char* end;
+            value = std::strtof(position, &end);
+            if (end == position) {
+                return false;
+            }
+            position = end;
+            return true;
+        }
+        bool read_vector(Vector3& value) {
+            return read_float(value.x) && read_float(value.y) && read_float(value.z);
+        }
+        bool read_int(int& value) {
+            char* end;
+            value = static_cast<int>(std::strtol(position, &end, 10));
+            if (end == position) {
+                return false;
+            }
+            position = end;
+            return true;
+        }
+        bool read_char(char expected) {
+            skip_spaces();
+            if (*position != expected) {
+                return false;
+            }
+            position++;
+            return true;
+        }
+        //one "v/t/n" face corner
+        bool read_face_corner(int& vertex_index, int& texture_index, int& normal_index) {
+            return read_int(vertex_index) && read_char('/') && read_int(texture_index) && read_char('/') && read_int(normal_index);
+        }
+    };
+
+    bool token_is(const std::pair<const char*, size_t>& token, const char* word) {
+        return token.second == std::strlen(word) && std::memcmp(token.first, word, token.second) == 0;
+    }
+}
 
 Model Loader::load_obj(const std::string& obj_file_path, const std::string& mtl_file_path) {
     std::ifstream objFile(obj_file_path);
@@ -8,15 +108,100 @@ Model Loader::load_obj(const std::string& obj_file_path, const std::string& mtl_
         return Model(); 
     }
 
-    std::ifstream mtlFile(mtl_file_path);
-    if (!mtlFile.is_open()) {
-        std::cerr << "Failed to open MTL file: " << mtl_file_path << std::endl;
-        objFile.close(); 
+    std::vector<Material> materials = load_materials(mtl_file_path);
+    if (materials.empty()) {
+        objFile.close();
         return Model();
     }
 
     Model parsing_model;
+    for (auto& material : materials) {
+        parsing_model.add_material(material);
+    }
+
+    std::string line;
+    Material* current_material_pointer = nullptr; 
+    //face corner lists only live for one line, they come out of here and get rewound after each face
+    Arena load_arena(LOAD_ARENA_BLOCK_SIZE);
+    while (std::getline(objFile, line)) {
+        Line_Reader reader(line);
+        std::pair<const char*, size_t> token = reader.read_token();
+        if (token_is(token, "usemtl")) {
+            std::pair<const char*, size_t> material_name = reader.read_token();
+
+            //look the material up in the model itself, faces keep a reference to it
+            current_material_pointer = parsing_model.find_material(std::string(material_name.first, material_name.second));
+        } else if (token_is(token, "v")) {
+            Vector3 vertex;
+            reader.read_vector(vertex);
+            parsing_model.add_vertex(vertex);
+        } else if (token_is(token, "vt")) {
+            Vertex_Texture texture;
+            reader.read_float(texture.start);
+            reader.read_float(texture.end);
+            parsing_model.add_texture(texture);
+        } else if (token_is(token, "vn")) {
+            Vector3 normal;
+            reader.read_vector(normal);
+            parsing_model.add_normal(normal);
+        } else if (token_is(token, "f")) {
+            if (!current_material_pointer) {
+                std::cerr << "No material specified for face. Skipping." << std::endl;
+                continue;
+            }
+
+            // Temporary vectors to store indices
+            Arena_Scope face_scope(load_arena);
+            Arena_Vector<int> temp_vertex_indexes{Arena_Allocator<int>(load_arena)};
+            Arena_Vector<int> temp_texture_indexes{Arena_Allocator<int>(load_arena)};
+            Arena_Vector<int> temp_normal_indexes{Arena_Allocator<int>(load_arena)};
+
+            int vertex_index, texture_index, normal_index;
+
+            while (reader.read_face_corner(vertex_index, texture_index, normal_index)) {
+                temp_vertex_indexes.push_back(vertex_index);
+                temp_texture_indexes.push_back(texture_index);
+                temp_normal_indexes.push_back(normal_index);
+            }
+
+            // Create a new face for each vertex index
+            if (!temp_vertex_indexes.empty()) {
+                int numVertices = temp_vertex_indexes.size();
+                for (int i = 2; i < numVertices; ++i) {
+                    Face face(*current_material_pointer);
+                    face.vertex_index[0] = temp_vertex_indexes[0] - 1;
+
+                    face.texture_index[0] = temp_texture_indexes[0] - 1;
+                    face.normal_index[0] = temp_normal_indexes[0] - 1;
+
+                    face.vertex_index[1] = temp_vertex_indexes[i - 1] - 1;
+                    face.texture_index[1] = temp_texture_indexes[i - 1] - 1;
+                    face.normal_index[1] = temp_normal_indexes[i - 1] - 1;
+                    
+                    face.vertex_index[2] = temp_vertex_indexes[i] - 1;
+                    face.texture_index[2] = temp_texture_indexes[i] - 1;
+                    face.normal_index[2] = temp_normal_indexes[i] - 1;
+                    parsing_model.add_face(face);
+                }
+            }
+        }
+
+    }
+    objFile.close();
+    parsing_model.find_origin();
+    parsing_model.build_adjacency();
+    parsing_model.build_meshlets();
+
+    return parsing_model;
+}
 
+std::vector<Material> Loader::load_materials(const std::string& mtl_file_path) {
+    std::vector<Material> materials;
+    std::ifstream mtlFile(mtl_file_path);
+    if (!mtlFile.is_open()) {
+        std::cerr << "Failed to open MTL file: " << mtl_file_path << std::endl;
+        return materials;
+    }
 
     Material current_material;
     std::string line;
@@ -26,7 +211,7 @@ Model Loader::load_obj(const std::string& obj_file_path, const std::string& mtl_
         iss >> token;
         if (token == "newmtl") {
             if (!current_material.name.empty()) {
-                parsing_model.add_material(current_material);
+                materials.push_back(current_material);
             }
             current_material = Material();
             iss >> current_material.name;
@@ -52,92 +237,233 @@ Model Loader::load_obj(const std::string& obj_file_path, const std::string& mtl_
             iss >> current_material.optical_density;
         } else if (token == "d") {
             iss >> current_material.dissolve_factor;
+        } else if (token == "Tr") {
+            //some exporters write transparency instead of dissolve
+            float transparency;
+            if (iss >> transparency) {
+                current_material.dissolve_factor = 1.0f - transparency;
+            }
         } else if (token == "illum") {
             iss >> current_material.illumination_model;
         } 
     }
     if (!current_material.name.empty()) {
-        parsing_model.add_material(current_material);
+        materials.push_back(current_material);
     }
     mtlFile.close();
+    return materials;
+}
 
+bool Loader::build_chunk_file(const std::string& obj_file_path, const std::string& mtl_file_path,
+                              const std::string& chunk_file_path, int cells_per_axis) {
+    std::vector<Material> materials = load_materials(mtl_file_path);
+    if (materials.empty()) {
+        return false;
+    }
 
-    Material* current_material_pointer = nullptr; 
-    while (std::getline(objFile, line)) {
-        std::istringstream iss(line);
-        std::string token;
-        iss >> token;
-        if (token == "usemtl") {
-            std::string materialName;
-            iss >> materialName;
-
-            for (auto& mat : parsing_model.get_materials()) {
-                if (mat.name == materialName) {
-                    current_material_pointer = &mat; 
-                    break;
-                }
-            }
-        } else if (token == "v") {
-            Vector3 vertex;
-            iss >> vertex.x >> vertex.y >> vertex.z;
-            parsing_model.add_vertex(vertex);
-        } else if (token == "vt") {
-            Vertex_Texture texture;
-            iss >> texture.start >> texture.end;
-            parsing_model.add_texture(texture);
-        } else if (token == "vn") {
-            Vector3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            parsing_model.add_normal(normal);
-        } else if (token == "f") {
-            if (!current_material_pointer) {
-                std::cerr << "No material specified for face. Skipping." << std::endl;
-                continue;
+    //pass 1: stream positions and normals out to temp files, all we keep in memory are the bounds
+    std::string positions_path = chunk_file_path + ".positions";
+    std::string normals_path = chunk_file_path + ".normals";
+    size_t vertex_count = 0, normal_count = 0;
+    Vector3 bounds_min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    Vector3 bounds_max = -bounds_min;
+    {
+        std::ifstream objFile(obj_file_path);
+        if (!objFile.is_open()) {
+            std::cerr << "Failed to open OBJ file: " << obj_file_path << std::endl;
+            return false;
+        }
+        std::ofstream positions_file(positions_path, std::ios::binary);
+        std::ofstream normals_file(normals_path, std::ios::binary);
+        std::string line;
+        while (std::getline(objFile, line)) {
+            Line_Reader reader(line);
+            std::pair<const char*, size_t> token = reader.read_token();
+            if (token_is(token, "v")) {
+                Vector3 vertex;
+                reader.read_vector(vertex);
+                positions_file.write(reinterpret_cast<const char*>(&vertex), sizeof(Vector3));
+                bounds_min = Vector3(std::min(bounds_min.x, vertex.x), std::min(bounds_min.y, vertex.y), std::min(bounds_min.z, vertex.z));
+                bounds_max = Vector3(std::max(bounds_max.x, vertex.x), std::max(bounds_max.y, vertex.y), std::max(bounds_max.z, vertex.z));
+                vertex_count++;
+            } else if (token_is(token, "vn")) {
+                Vector3 normal;
+                reader.read_vector(normal);
+                normals_file.write(reinterpret_cast<const char*>(&normal), sizeof(Vector3));
+                normal_count++;
             }
+        }
+    }
 
-            // Temporary vectors to store indices
-            std::vector<int> temp_vertex_indexes;
-            std::vector<int> temp_texture_indexes;
-            std::vector<int> temp_normal_indexes;
+    Mapped_File positions, normals;
+    if (!positions.open(positions_path, vertex_count * sizeof(Vector3)) || !normals.open(normals_path, normal_count * sizeof(Vector3))) {
+        std::cerr << "Failed to map vertex data for: " << obj_file_path << std::endl;
+        std::remove(positions_path.c_str());
+        std::remove(normals_path.c_str());
+        return false;
+    }
 
-            char separator;
-            int vertex_index, texture_index, normal_index;
+    //pass 2: resolve each face and drop it into the grid cell its centroid lands in
+    int cell_count = cells_per_axis * cells_per_axis * cells_per_axis;
+    Vector3 extent = bounds_max - bounds_min;
+    Vector3 cell_scale(
+        extent.x > 0 ? cells_per_axis / extent.x : 0.0f,
+        extent.y > 0 ? cells_per_axis / extent.y : 0.0f,
+        extent.z > 0 ? cells_per_axis / extent.z : 0.0f
+    );
+    std::vector<std::vector<Chunk_Triangle>> cell_buffers(cell_count);
+    std::vector<size_t> cell_triangle_counts(cell_count, 0);
+    auto cell_path = [&](int cell) { return chunk_file_path + ".cell" + std::to_string(cell); };
+    auto flush_cell = [&](int cell) {
+        //opened per flush so thousands of cells never need thousands of open files
+        std::ofstream cell_file(cell_path(cell), std::ios::binary | std::ios::app);
+        cell_file.write(reinterpret_cast<const char*>(cell_buffers[cell].data()), cell_buffers[cell].size() * sizeof(Chunk_Triangle));
+        cell_buffers[cell].clear();
+    };
 
-            while (iss >> vertex_index >> separator >> texture_index >> separator >> normal_index) {
-                temp_vertex_indexes.push_back(vertex_index);
-                temp_texture_indexes.push_back(texture_index);
-                temp_normal_indexes.push_back(normal_index);
+    auto remove_cell_files = [&]() {
+        for (int cell = 0; cell < cell_count; ++cell) {
+            if (cell_triangle_counts[cell] > 0) {
+                std::remove(cell_path(cell).c_str());
             }
+        }
+    };
+    //1 based, or negative to count back from the last one read so far. anything else comes back as -1
+    auto resolve_index = [](int index, size_t seen_count) {
+        return index > 0 ? index - 1 : (index < 0 ? static_cast<int>(seen_count) + index : -1);
+    };
 
-            // Create a new face for each vertex index
-            if (!temp_vertex_indexes.empty()) {
-                int numVertices = temp_vertex_indexes.size();
-                for (int i = 2; i < numVertices; ++i) {
-                    Face face(*current_material_pointer);
-                    face.vertex_index[0] = temp_vertex_indexes[0] - 1;
-                    parsing_model.add_vertex_face_info(temp_vertex_indexes[0] - 1, temp_normal_indexes[0] - 1);
+    size_t skipped_faces = 0, invalid_faces = 0;
+    {
+        std::ifstream objFile(obj_file_path);
+        std::string line;
+        const Material* current_material_pointer = nullptr;
+        std::vector<int> temp_vertex_indexes, temp_normal_indexes;
+        size_t seen_vertices = 0, seen_normals = 0;  //relative indices count back from here
+        while (std::getline(objFile, line)) {
+            Line_Reader reader(line);
+            std::pair<const char*, size_t> token = reader.read_token();
+            if (token_is(token, "v")) {
+                seen_vertices++;
+            } else if (token_is(token, "vn")) {
+                seen_normals++;
+            } else if (token_is(token, "usemtl")) {
+                std::pair<const char*, size_t> material_name = reader.read_token();
+                current_material_pointer = nullptr;
+                for (const auto& material : materials) {
+                    if (material.name.compare(0, std::string::npos, material_name.first, material_name.second) == 0) {
+                        current_material_pointer = &material;
+                        break;
+                    }
+                }
+            } else if (token_is(token, "f")) {
+                if (!current_material_pointer) {
+                    skipped_faces++;
+                    continue;
+                }
+                temp_vertex_indexes.clear();
+                temp_normal_indexes.clear();
+                int vertex_index, texture_index, normal_index;
+                bool in_range = true;
+                while (reader.read_face_corner(vertex_index, texture_index, normal_index)) {
+                    temp_vertex_indexes.push_back(resolve_index(vertex_index, seen_vertices));
+                    temp_normal_indexes.push_back(resolve_index(normal_index, seen_normals));
+                    //the mapped files end right after the last vertex and normal, reading past them can fault
+                    in_range = in_range && temp_vertex_indexes.back() >= 0 && temp_vertex_indexes.back() < static_cast<int>(vertex_count)
+                        && temp_normal_indexes.back() >= 0 && temp_normal_indexes.back() < static_cast<int>(normal_count);
+                }
+                if (!in_range) {
+                    invalid_faces++;
+                    continue;
+                }
 
-                    face.texture_index[0] = temp_texture_indexes[0] - 1;
-                    face.normal_index[0] = temp_normal_indexes[0] - 1;
+                for (size_t i = 2; i < temp_vertex_indexes.size(); ++i) {
+                    Chunk_Triangle triangle;
+                    triangle.vertices[0] = positions.as_vectors()[temp_vertex_indexes[0]];
+                    triangle.vertices[1] = positions.as_vectors()[temp_vertex_indexes[i - 1]];
+                    triangle.vertices[2] = positions.as_vectors()[temp_vertex_indexes[i]];
+                    triangle.normal = normals.as_vectors()[temp_normal_indexes[0]];
+                    triangle.color = current_material_pointer->diffuse_color;
 
-                    face.vertex_index[1] = temp_vertex_indexes[i - 1] - 1;
-                    parsing_model.add_vertex_face_info(temp_vertex_indexes[i-1] - 1, temp_normal_indexes[i-1] - 1);
-                    face.texture_index[1] = temp_texture_indexes[i - 1] - 1;
-                    face.normal_index[1] = temp_normal_indexes[i - 1] - 1;
-                    
-                    face.vertex_index[2] = temp_vertex_indexes[i] - 1;
-                    parsing_model.add_vertex_face_info(temp_vertex_indexes[i] - 1, temp_normal_indexes[i] - 1);
-                    face.texture_index[2] = temp_texture_indexes[i] - 1;
-                    face.normal_index[2] = temp_normal_indexes[i] - 1;
-                    parsing_model.add_face(face);
+                    Vector3 centroid = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) / 3.0f;
+                    int cell_x = std::min(cells_per_axis - 1, static_cast<int>((centroid.x - bounds_min.x) * cell_scale.x));
+                    int cell_y = std::min(cells_per_axis - 1, static_cast<int>((centroid.y - bounds_min.y) * cell_scale.y));
+                    int cell_z = std::min(cells_per_axis - 1, static_cast<int>((centroid.z - bounds_min.z) * cell_scale.z));
+                    int cell = (cell_z * cells_per_axis + cell_y) * cells_per_axis + cell_x;
+
+                    cell_buffers[cell].push_back(triangle);
+                    cell_triangle_counts[cell]++;
+                    if (cell_buffers[cell].size() >= CELL_FLUSH_SIZE) {
+                        flush_cell(cell);
+                    }
                 }
             }
         }
+    }
+    for (int cell = 0; cell < cell_count; ++cell) {
+        if (!cell_buffers[cell].empty()) {
+            flush_cell(cell);
+        }
+    }
+    std::remove(positions_path.c_str());
+    std::remove(normals_path.c_str());
+    if (skipped_faces > 0) {
+        std::cerr << "No material specified for " << skipped_faces << " faces. Skipped." << std::endl;
+    }
+    if (invalid_faces > 0) {
+        std::cerr << "Vertex or normal index out of range in " << invalid_faces << " faces of " << obj_file_path << ". Skipped." << std::endl;
+    }
 
+    //pass 3: stitch the non empty cells together behind the header and chunk table
+    std::vector<Chunk_Info> chunk_table;
+    for (int cell = 0; cell < cell_count; ++cell) {
+        if (cell_triangle_counts[cell] > 0) {
+            chunk_table.push_back(Chunk_Info{Vector3(), Vector3(), 0, cell_triangle_counts[cell]});
+        }
     }
-    objFile.close();
-    parsing_model.find_origin();
+    Chunk_File_Header header;
+    std::copy(CHUNK_FILE_MAGIC, CHUNK_FILE_MAGIC + sizeof(CHUNK_FILE_MAGIC), header.magic);
+    header.chunk_count = static_cast<uint32_t>(chunk_table.size());
+    header.padding = 0;
 
-    return parsing_model;
-}
+    std::ofstream chunk_file(chunk_file_path, std::ios::binary | std::ios::trunc);
+    if (!chunk_file.is_open()) {
+        std::cerr << "Failed to create chunk file: " << chunk_file_path << std::endl;
+        remove_cell_files();
+        return false;
+    }
+    chunk_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    chunk_file.write(reinterpret_cast<const char*>(chunk_table.data()), chunk_table.size() * sizeof(Chunk_Info));
+
+    std::vector<Chunk_Triangle> copy_buffer(CELL_FLUSH_SIZE);
+    size_t chunk_index = 0;
+    for (int cell = 0; cell < cell_count; ++cell) {
+        if (cell_triangle_counts[cell] == 0) {
+            continue;
+        }
+        Chunk_Info& chunk = chunk_table[chunk_index++];
+        chunk.offset = static_cast<uint64_t>(chunk_file.tellp());
+        chunk.bounds_min = Vector3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        chunk.bounds_max = -chunk.bounds_min;
 
+        std::ifstream cell_file(cell_path(cell), std::ios::binary);
+        while (cell_file.read(reinterpret_cast<char*>(copy_buffer.data()), copy_buffer.size() * sizeof(Chunk_Triangle)) || cell_file.gcount() > 0) {
+            size_t read_count = cell_file.gcount() / sizeof(Chunk_Triangle);
+            for (size_t i = 0; i < read_count; ++i) {
+                for (const Vector3& vertex : copy_buffer[i].vertices) {
+                    chunk.bounds_min = Vector3(std::min(chunk.bounds_min.x, vertex.x), std::min(chunk.bounds_min.y, vertex.y), std::min(chunk.bounds_min.z, vertex.z));
+                    chunk.bounds_max = Vector3(std::max(chunk.bounds_max.x, vertex.x), std::max(chunk.bounds_max.y, vertex.y), std::max(chunk.bounds_max.z, vertex.z));
+                }
+            }
+            chunk_file.write(reinterpret_cast<const char*>(copy_buffer.data()), read_count * sizeof(Chunk_Triangle));
+        }
+        cell_file.close();
+        std::remove(cell_path(cell).c_str());
+    }
+
+    //bounds and offsets are only known now, go back and fill in the table
+    chunk_file.seekp(sizeof(header));
+    chunk_file.write(reinterpret_cast<const char*>(chunk_table.data()), chunk_table.size() * sizeof(Chunk_Info));
+    chunk_file.close();
+    return true;
+}
@@ -8,10 +8,15 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <vector>
 
 class Loader {
 public:
     static Model load_obj(const std::string& obj_file_path, const std::string& mtl_file_path);
+    static std::vector<Material> load_materials(const std::string& mtl_file_path);
+    //splits an OBJ into cells_per_axis^3 spatial chunks for Streamed_Mesh, never holds more than the vertex data mapped at once
+    static bool build_chunk_file(const std::string& obj_file_path, const std::string& mtl_file_path,
+                                 const std::string& chunk_file_path, int cells_per_axis = 8);
 };
 
 #endif 
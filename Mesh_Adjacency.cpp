@@ -0,0 +1,159 @@
+#include "Mesh_Adjacency.h"
+#include "Model.h"
+
+//-------------------------------------Mesh_Adjacency---------------------------------------------
+void Mesh_Adjacency::build(const std::vector<Face>& faces, int vertex_count) {
+    //counting sort, count every vertex's corners, turn the counts into offsets, then drop each corner into place
+    corner_offsets.assign(vertex_count + 1, 0);
+    for (const Face& face : faces) {
+        for (int slot = 0; slot < 3; ++slot) {
+            int vertex = face.vertex_index[slot];
+            if (vertex >= 0 && vertex < vertex_count) {
+                corner_offsets[vertex + 1]++;
+            }
+        }
+    }
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        corner_offsets[vertex + 1] += corner_offsets[vertex];
+    }
+    vertex_corners.resize(corner_offsets[vertex_count]);
+
+    //offsets doubles as the write cursor and ends up shifted one vertex along, the shift back restores it
+    for (int face_index = 0; face_index < static_cast<int>(faces.size()); ++face_index) {
+        for (int slot = 0; slot < 3; ++slot) {
+            int vertex = faces[face_index].vertex_index[slot];
+            if (vertex >= 0 && vertex < vertex_count) {
+                vertex_corners[corner_offsets[vertex]++] = face_index * 3 + slot;
+            }
+        }
+    }
+    for (int vertex = vertex_count; vertex > 0; --vertex) {
+        corner_offsets[vertex] = corner_offsets[vertex - 1];
+    }
+    corner_offsets[0] = 0;
+}
+
+//-------------------------------------Half_Edge_Mesh---------------------------------------------
+void Half_Edge_Mesh::build(const Model& model) {
+    const std::vector<Face>& faces = model.get_faces();
+    const Mesh_Adjacency& adjacency = model.get_adjacency();
+    int vertex_count = adjacency.get_vertex_count();
+    int half_edge_count = static_cast<int>(faces.size()) * 3;
+
+    origins.resize(half_edge_count);
+    for (int half_edge = 0; half_edge < half_edge_count; ++half_edge) {
+        origins[half_edge] = faces[get_face(half_edge)].vertex_index[half_edge % 3];
+    }
+
+    //the corners at a vertex are exactly its outgoing half-edges, so the twin of a->b is whichever of b's goes back to a
+    twins.assign(half_edge_count, -1);
+    boundary_edge_count = 0;
+    non_manifold_edge_count = 0;
+    for (int half_edge = 0; half_edge < half_edge_count; ++half_edge) {
+        int from = origins[half_edge];
+        int to = get_destination(half_edge);
+        if (from < 0 || from >= vertex_count || to < 0 || to >= vertex_count) {
+            non_manifold_edge_count++;
+            continue;
+        }
+        int twin = -1;
+        int reverse_count = 0;
+        for (const int* corner = adjacency.corners_begin(to); corner != adjacency.corners_end(to); ++corner) {
+            if (get_destination(*corner) == from) {
+                twin = *corner;
+                reverse_count++;
+            }
+        }
+        int same_count = 0;
+        for (const int* corner = adjacency.corners_begin(from); corner != adjacency.corners_end(from); ++corner) {
+            if (*corner != half_edge && get_destination(*corner) == to) {
+                same_count++;
+            }
+        }
+        if (reverse_count == 1 && same_count == 0) {
+            twins[half_edge] = twin;
+        } else if (reverse_count == 0 && same_count == 0) {
+            boundary_edge_count++;
+        } else {
+            non_manifold_edge_count++;  //left without a twin, walks treat it like a boundary
+        }
+    }
+
+    //starting a vertex's walk from the half-edge with no twin means a boundary fan is covered end to end
+    vertex_half_edges.assign(vertex_count, -1);
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const int* corner = adjacency.corners_begin(vertex); corner != adjacency.corners_end(vertex); ++corner) {
+            if (vertex_half_edges[vertex] == -1 || twins[*corner] == -1) {
+                vertex_half_edges[vertex] = *corner;
+            }
+            if (twins[*corner] == -1) {
+                break;
+            }
+        }
+    }
+
+    //one fan holding every face at the vertex, and that fan has at most one gap
+    manifold_vertices.assign(vertex_count, 1);
+    non_manifold_vertex_count = 0;
+    for (int vertex = 0; vertex < vertex_count; ++vertex) {
+        int open_count = 0;
+        for (const int* corner = adjacency.corners_begin(vertex); corner != adjacency.corners_end(vertex); ++corner) {
+            open_count += twins[*corner] == -1;
+        }
+        if (open_count > 1 || count_fan(vertex) != adjacency.get_corner_count(vertex)) {
+            manifold_vertices[vertex] = 0;
+            non_manifold_vertex_count++;
+        }
+    }
+}
+
+int Half_Edge_Mesh::count_fan(int vertex) const {
+    //rotate around the vertex through the faces, prev comes into the vertex and its twin leaves it again one face over
+    int start = vertex_half_edges[vertex];
+    if (start == -1) {
+        return 0;
+    }
+    int count = 0;
+    int half_edge = start;
+    do {
+        count++;
+        half_edge = twins[get_prev(half_edge)];
+    } while (half_edge != -1 && half_edge != start);
+    return count;
+}
+
+bool Half_Edge_Mesh::is_boundary_vertex(int vertex) const {
+    int half_edge = vertex_half_edges[vertex];
+    return half_edge == -1 || twins[half_edge] == -1;
+}
+
+void Half_Edge_Mesh::get_one_ring(int vertex, std::vector<int>& neighbours) const {
+    neighbours.clear();
+    int start = vertex_half_edges[vertex];
+    if (start == -1) {
+        return;
+    }
+    int half_edge = start;
+    while (true) {
+        neighbours.push_back(get_destination(half_edge));
+        int incoming = get_prev(half_edge);
+        if (twins[incoming] == -1) {
+            //a boundary fan ends on an edge only one face has, its far vertex is the last neighbour
+            neighbours.push_back(origins[incoming]);
+            return;
+        }
+        half_edge = twins[incoming];
+        if (half_edge == start) {
+            return;
+        }
+    }
+}
+
+void Half_Edge_Mesh::get_boundary_edges(std::vector<int>& half_edges) const {
+    half_edges.clear();
+    for (int half_edge = 0; half_edge < get_half_edge_count(); ++half_edge) {
+        if (twins[half_edge] == -1) {
+            half_edges.push_back(half_edge);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+File Description:
+- Connectivity for a triangle model, built once after loading.
+- Mesh_Adjacency is a compressed (CSR) list of the face corners touching every
+- vertex: one offset per vertex into one flat array, two allocations for the
+- whole model. A corner is face * 3 + slot, so the face and the exact
+- vertex/normal/texture slot it used both come straight out of it.
+- Half_Edge_Mesh is the optional heavier structure for walking the surface,
+- one half-edge per corner with next, previous and face implied by the index
+- and only the twins stored. It answers one-ring, boundary and manifold
+- questions for normal generation, simplification and culling.
+
+Important References:
+- https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_row_(CSR,_CRS_or_Yale_format)
+- https://en.wikipedia.org/wiki/Doubly_connected_edge_list (half-edges)
+*/
+
+#ifndef MESH_ADJACENCY_H
+#define MESH_ADJACENCY_H
+//Standard C Libraries
+#include <vector>   //offset and corner arrays
+#include <cstddef>  //memory sizes
+#include <cstdint>  //vertex flags
+
+//the model owns a Mesh_Adjacency, so only declared here
+struct Face;
+class Model;
+
+//face * 3 + slot, the slot is 0-2 into the face's index arrays
+inline int get_corner_face(int corner) { return corner / 3; }
+inline int get_corner_slot(int corner) { return corner % 3; }
+
+class Mesh_Adjacency {
+    private:
+        std::vector<int> corner_offsets;  //vertex_count + 1 entries, a vertex's corners are [offsets[v], offsets[v + 1])
+        std::vector<int> vertex_corners;  //grouped by vertex, in face order within each vertex
+
+    public:
+        //corners pointing outside [0, vertex_count) are left out, a broken face should not take the rest down with it
+        void build(const std::vector<Face>& faces, int vertex_count);
+
+        int get_vertex_count() const { return corner_offsets.empty() ? 0 : static_cast<int>(corner_offsets.size()) - 1; }
+        int get_corner_count(int vertex) const { return corner_offsets[vertex + 1] - corner_offsets[vertex]; }
+        const int* corners_begin(int vertex) const { return vertex_corners.data() + corner_offsets[vertex]; }
+        const int* corners_end(int vertex) const { return vertex_corners.data() + corner_offsets[vertex + 1]; }
+        size_t get_memory_bytes() const { return (corner_offsets.capacity() + vertex_corners.capacity()) * sizeof(int); }
+};
+
+class Half_Edge_Mesh {
+    private:
+        std::vector<int> origins;  //vertex each half-edge starts at, half-edge h goes from origins[h] to origins[get_next(h)]
+        std::vector<int> twins;    //the opposite half-edge in the neighbouring face, -1 on a boundary or a non-manifold edge
+        std::vector<int> vertex_half_edges; //one outgoing half-edge per vertex, the boundary one when there is one, -1 if unused
+        std::vector<uint8_t> manifold_vertices; //1 where the vertex's faces form a single fan with at most one gap
+        int boundary_edge_count = 0;
+        int non_manifold_edge_count = 0;   //half-edges whose edge has more than two faces or faces wound opposite ways
+        int non_manifold_vertex_count = 0; //vertices whose faces do not form a single fan
+
+        int count_fan(int vertex) const;
+
+    public:
+        //needs the model's adjacency built, Model::build_adjacency does that on load
+        void build(const Model& model);
+
+        static int get_next(int half_edge) { return half_edge - half_edge % 3 + (half_edge + 1) % 3; }
+        static int get_prev(int half_edge) { return half_edge - half_edge % 3 + (half_edge + 2) % 3; }
+        static int get_face(int half_edge) { return half_edge / 3; }
+        int get_origin(int half_edge) const { return origins[half_edge]; }
+        int get_destination(int half_edge) const { return origins[get_next(half_edge)]; }
+        int get_twin(int half_edge) const { return twins[half_edge]; }
+        int get_vertex_half_edge(int vertex) const { return vertex_half_edges[vertex]; }
+        int get_half_edge_count() const { return static_cast<int>(origins.size()); }
+
+        bool is_boundary_edge(int half_edge) const { return twins[half_edge] == -1; }
+        bool is_boundary_vertex(int vertex) const;
+        bool is_manifold_vertex(int vertex) const { return manifold_vertices[vertex] != 0; }
+        bool is_manifold() const { return non_manifold_edge_count == 0 && non_manifold_vertex_count == 0; }
+
+        //neighbouring vertices in winding order around the vertex, for a non-manifold vertex only its first fan
+        void get_one_ring(int vertex, std::vector<int>& neighbours) const;
+        void get_boundary_edges(std::vector<int>& half_edges) const; //every half-edge without a twin, non-manifold ones included
+
+        int get_boundary_edge_count() const { return boundary_edge_count; }
+        int get_non_manifold_edge_count() const { return non_manifold_edge_count; }
+        int get_non_manifold_vertex_count() const { return non_manifold_vertex_count; }
+        size_t get_memory_bytes() const {
+            return (origins.capacity() + twins.capacity() + vertex_half_edges.capacity()) * sizeof(int) + manifold_vertices.capacity();
+        }
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Model.h"
+#include <algorithm>
 
 void Model::find_origin() {
     Vector3 origin;
@@ -16,85 +17,141 @@ void Model::find_origin() {
 }
 
 //-------------------------------------Model_Transforms------------------------------------------
-void Model::rotate(float x, float y, float z){
-    for(auto& vertex : this->vertices){
-        // X rotation
-        float temp_y = vertex.y;
-        vertex.y = std::cos(x) * vertex.y - std::sin(x) * vertex.z;
-        vertex.z = std::sin(x) * temp_y + std::cos(x) * vertex.z;
+//x, then y, then z rotation around the world origin
+static void rotate_vector(Vector3& vector, float x, float y, float z){
+    // X rotation
+    float temp_y = vector.y;
+    vector.y = std::cos(x) * vector.y - std::sin(x) * vector.z;
+    vector.z = std::sin(x) * temp_y + std::cos(x) * vector.z;
+
+    // Y rotation
+    float temp_x = vector.x;
+    vector.x = std::cos(y) * vector.x + std::sin(y) * vector.z;
+    vector.z = -std::sin(y) * temp_x + std::cos(y) * vector.z;
 
-        // Y rotation
-        float temp_x = vertex.x;
-        vertex.x = std::cos(y) * vertex.x + std::sin(y) * vertex.z;
-        vertex.z = -std::sin(y) * temp_x + std::cos(y) * vertex.z;
+    // Z rotation
+    temp_x = vector.x;
+    vector.x = std::cos(z) * vector.x - std::sin(z) * vector.y;
+    vector.y = std::sin(z) * temp_x + std::cos(z) * vector.y;
+}
 
-        // Z rotation
-        temp_x = vertex.x;
-        vertex.x = std::cos(z) * vertex.x - std::sin(z) * vertex.y;
-        vertex.y = std::sin(z) * temp_x + std::cos(z) * vertex.y;
+void Model::rotate(float x, float y, float z){
+    if (!require_vertex_streams("rotate")) {
+        return;
+    }
+    mark_changed();
+    for(auto& vertex : this->vertices){
+        rotate_vector(vertex, x, y, z);
     }
 
     for(auto& normal : this->normals){
-        // X rotation
-        float temp_y = normal.y;
-        normal.y = std::cos(x) * normal.y - std::sin(x) * normal.z;
-        normal.z = std::sin(x) * temp_y + std::cos(x) * normal.z;
-
-        // Y rotation
-        float temp_x = normal.x;
-        normal.x = std::cos(y) * normal.x + std::sin(y) * normal.z;
-        normal.z = -std::sin(y) * temp_x + std::cos(y) * normal.z;
+        rotate_vector(normal, x, y, z);
+    }
 
-        // Z rotation
-        temp_x = normal.x;
-        normal.x = std::cos(z) * normal.x - std::sin(z) * normal.y;
-        normal.y = std::sin(z) * temp_x + std::cos(z) * normal.y;
+    //rotation is rigid, so the meshlet spheres and cones just turn with the mesh
+    for(auto& meshlet : this->meshlets){
+        rotate_vector(meshlet.center, x, y, z);
+        rotate_vector(meshlet.cone_axis, x, y, z);
     }
 }
 
 void Model::rotate_around_point(float x, float y, float z, Vector3 point){
+    if (!require_vertex_streams("rotate")) {
+        return;
+    }
     for(auto& vertex : this->vertices){
         vertex.x -= point.x;
         vertex.y -= point.y;
         vertex.z -= point.z;
     }
+    for(auto& meshlet : this->meshlets){
+        meshlet.center = meshlet.center - point;
+    }
     rotate(x,y,z);
     for(auto& vertex : this->vertices){
         vertex.x += point.x;
         vertex.y += point.y;
         vertex.z += point.z;
     }
+    for(auto& meshlet : this->meshlets){
+        meshlet.center = meshlet.center + point;
+    }
 
 
 }
 
 void Model::scale(float scalar){
+    if (!require_vertex_streams("scale")) {
+        return;
+    }
+    mark_changed();
     for (auto& vertex : this->vertices){
         vertex.x = vertex.x * scalar;
         vertex.y = vertex.y * scalar;
         vertex.z = vertex.z * scalar;
     }
+    for (auto& meshlet : this->meshlets){
+        meshlet.center = meshlet.center * scalar;
+        meshlet.radius = meshlet.radius * std::fabs(scalar);
+    }
     find_origin();
 }
 
 void Model::translate(float x, float y, float z) {
+    if (!require_vertex_streams("translate")) {
+        return;
+    }
+    mark_changed();
     for (auto& vertex : vertices) {
         vertex.x += x;
         vertex.y += y;
         vertex.z += z;
     }
+    for (auto& meshlet : meshlets) {
+        meshlet.center = meshlet.center + Vector3(x, y, z);
+    }
     find_origin();
 }
 
 //-------------------------------------Getters----------------------------------------------------
 const std::vector<Vector3>& Model::get_vertices() const { return vertices;}
-const std::vector<std::vector<int>>& Model::get_vertex_info() const {return vertices_info;};
 const std::vector<Vector3>& Model::get_normals() const { return normals;}
 const std::vector<Face>& Model::get_faces() const { return faces;}
 std::vector<Material> Model::get_materials() const {return materials;}
 const std::vector<Vertex_Texture>& Model::get_textures() const { return textures;}
 
+Material* Model::find_material(const std::string& name) {
+    for (auto& material : this->materials) {
+        if (material.name == name) {
+            mark_changed();  //the caller may edit what it gets back
+            return &material;
+        }
+    }
+    return nullptr;
+}
+
+const Material* Model::find_material(const std::string& name) const {
+    for (const auto& material : this->materials) {
+        if (material.name == name) {
+            return &material;
+        }
+    }
+    return nullptr;
+}
+
+bool Model::has_translucent_materials() const {
+    for (const auto& material : this->materials) {
+        if (material.dissolve_factor < 1.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
 const Vector3& Model::get_center_of_origin() const { return center_of_origin;}
+const std::vector<Meshlet>& Model::get_meshlets() const { return meshlets;}
+const std::vector<int>& Model::get_meshlet_vertices() const { return meshlet_vertices;}
+const std::vector<uint8_t>& Model::get_meshlet_triangles() const { return meshlet_triangles;}
 
 //--------------------------------------Adders----------------------------------------------------
 void Model::add_vertex(Vector3 vertex){this->vertices.push_back(vertex);}
@@ -104,14 +161,161 @@ void Model::add_material(Material material){this->materials.push_back(material);
 void Model::add_texture(Vertex_Texture vertex_texture){this->textures.push_back(vertex_texture);}
 
 
-void Model::add_vertex_face_info(int vertex_index, int face_index) {
-    // If the vertex_index is greater than or equal to the current size,
-    // resize the vector to make sure it can accommodate the new vertex_index
-    if (vertex_index >= vertices_info.size()) {
-        vertices_info.resize(vertex_index + 1); // Resize to accommodate the new index
+bool Model::require_vertex_streams(const char* action) const {
+    if (vertex_streams_released) {
+        //the meshlets would move but a Quantized_Mesh built from the old positions would not, so refuse instead
+        std::cerr << "Cannot " << action << " a model whose vertex streams were released" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Model::release_vertex_streams() {
+    mark_changed();
+    vertex_streams_released = true;
+    //swapping with empty vectors is the only way to be sure the capacity goes too
+    std::vector<Vector3>().swap(vertices);
+    std::vector<Vector3>().swap(normals);
+    std::vector<Vertex_Texture>().swap(textures);
+}
+
+void Model::build_adjacency() {
+    if (!require_vertex_streams("build adjacency for")) {
+        return;
     }
+    //one pass after loading instead of growing a list per vertex while the faces come in
+    adjacency.build(faces, static_cast<int>(vertices.size()));
+}
 
-    // Add the face index to the specified vertex
-    vertices_info[vertex_index].push_back(face_index);
+void Model::get_bounds(Vector3& bounds_min, Vector3& bounds_max) const {
+    //built from the meshlet spheres, the transforms keep those current so this never has to touch the vertices
+    bounds_min = Vector3();
+    bounds_max = Vector3();
+    for (size_t i = 0; i < meshlets.size(); ++i) {
+        Vector3 extent(meshlets[i].radius, meshlets[i].radius, meshlets[i].radius);
+        Vector3 sphere_min = meshlets[i].center - extent;
+        Vector3 sphere_max = meshlets[i].center + extent;
+        if (i == 0) {
+            bounds_min = sphere_min;
+            bounds_max = sphere_max;
+            continue;
+        }
+        bounds_min = Vector3(std::min(bounds_min.x, sphere_min.x), std::min(bounds_min.y, sphere_min.y), std::min(bounds_min.z, sphere_min.z));
+        bounds_max = Vector3(std::max(bounds_max.x, sphere_max.x), std::max(bounds_max.y, sphere_max.y), std::max(bounds_max.z, sphere_max.z));
+    }
 }
 
+//--------------------------------------Meshlets--------------------------------------------------
+void Model::build_meshlets() {
+    if (!require_vertex_streams("build meshlets for")) {
+        return;
+    }
+    mark_changed();
+    meshlets.clear();
+    meshlet_vertices.clear();
+    meshlet_triangles.clear();
+    meshlet_triangles.reserve(faces.size() * 3);
+
+    //greedy, walk the faces in file order and start a new meshlet when either limit would be passed,
+    //exporters write faces in connected runs so neighbours usually end up together
+    std::vector<int> local_slot(vertices.size(), -1);
+    Meshlet current = {0, 0, 0, 0, Vector3(), 0.0f, Vector3(), 1.0f};
+    auto close_meshlet = [&]() {
+        for (int i = current.vertex_offset; i < current.vertex_offset + current.vertex_count; ++i) {
+            local_slot[meshlet_vertices[i]] = -1;
+        }
+        meshlets.push_back(current);
+        current.vertex_offset = static_cast<int>(meshlet_vertices.size());
+        current.vertex_count = 0;
+        current.face_offset += current.triangle_count;
+        current.triangle_count = 0;
+    };
+
+    for (const auto& face : faces) {
+        int new_vertices = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            //a face that repeats a vertex would count it twice here, that only makes the meshlet close a little early
+            if (local_slot[face.vertex_index[corner]] == -1) {
+                new_vertices++;
+            }
+        }
+        if (current.vertex_count + new_vertices > MESHLET_MAX_VERTICES || current.triangle_count + 1 > MESHLET_MAX_TRIANGLES) {
+            close_meshlet();
+        }
+
+        for (int corner = 0; corner < 3; ++corner) {
+            int vertex_index = face.vertex_index[corner];
+            if (local_slot[vertex_index] == -1) {
+                local_slot[vertex_index] = current.vertex_count++;
+                meshlet_vertices.push_back(vertex_index);
+            }
+            meshlet_triangles.push_back(static_cast<uint8_t>(local_slot[vertex_index]));
+        }
+        current.triangle_count++;
+    }
+    if (current.triangle_count > 0) {
+        close_meshlet();
+    }
+
+    update_meshlet_bounds();
+}
+
+void Model::update_meshlet_bounds() {
+    if (!require_vertex_streams("update the meshlet bounds of")) {
+        return;
+    }
+    mark_changed();
+    std::vector<Vector3> face_normals;
+    face_normals.reserve(MESHLET_MAX_TRIANGLES);
+    for (auto& meshlet : meshlets) {
+        //sphere around the box of the local vertices, not the tightest sphere but cheap and never too small
+        Vector3 bounds_min = vertices[meshlet_vertices[meshlet.vertex_offset]];
+        Vector3 bounds_max = bounds_min;
+        for (int i = meshlet.vertex_offset; i < meshlet.vertex_offset + meshlet.vertex_count; ++i) {
+            const Vector3& vertex = vertices[meshlet_vertices[i]];
+            bounds_min = Vector3(std::min(bounds_min.x, vertex.x), std::min(bounds_min.y, vertex.y), std::min(bounds_min.z, vertex.z));
+            bounds_max = Vector3(std::max(bounds_max.x, vertex.x), std::max(bounds_max.y, vertex.y), std::max(bounds_max.z, vertex.z));
+        }
+        meshlet.center = (bounds_min + bounds_max) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (int i = meshlet.vertex_offset; i < meshlet.vertex_offset + meshlet.vertex_count; ++i) {
+            Vector3 offset = vertices[meshlet_vertices[i]] - meshlet.center;
+            meshlet.radius = std::max(meshlet.radius, std::sqrt(dot_product(offset, offset)));
+        }
+
+        //normal cone, face normals come from the winding but get flipped to agree with the file normals
+        face_normals.clear();
+        Vector3 axis;
+        for (int i = meshlet.face_offset; i < meshlet.face_offset + meshlet.triangle_count; ++i) {
+            const Face& face = faces[i];
+            const Vector3& vertex_0 = vertices[face.vertex_index[0]];
+            Vector3 normal = cross_product(vertices[face.vertex_index[1]] - vertex_0, vertices[face.vertex_index[2]] - vertex_0);
+            float length = std::sqrt(dot_product(normal, normal));
+            if (length == 0.0f) {
+                continue;  //degenerate, faces nothing
+            }
+            normal = normal / length;
+            if (!normals.empty() && dot_product(normal, normals[face.normal_index[0]]) < 0.0f) {
+                normal = -normal;
+            }
+            face_normals.push_back(normal);
+            axis = axis + normal;
+        }
+
+        meshlet.cone_axis = Vector3(0, 0, 1);
+        meshlet.cone_cutoff = 1.0f;
+        float axis_length = std::sqrt(dot_product(axis, axis));
+        if (face_normals.empty() || axis_length == 0.0f) {
+            continue;
+        }
+        meshlet.cone_axis = axis / axis_length;
+        float min_dot = 1.0f;
+        for (const auto& normal : face_normals) {
+            min_dot = std::min(min_dot, dot_product(normal, meshlet.cone_axis));
+        }
+        //past about 84 degrees of spread there is almost no view from which every face points away, skip the test
+        if (min_dot > 0.1f) {
+            meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+        }
+    }
+}
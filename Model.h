@@ -21,24 +21,27 @@ Important References:
 #include <fstream>  //hangles reading files
 #include <sstream>  //operations for strings
 #include <string>   //strings
+#include <cstdint>  //compact meshlet indices
 //Created Files
 #include "Utilities.h"
+#include "Mesh_Adjacency.h"
 //-----------------------------------Data_Structures----------------------
 struct Vertex_Texture {
     float start, end;
 };
 
+//defaults are the MTL spec's, so a file that leaves a statement out still gets something sensible
 struct Material{
     std::string name;
-    Color ambient_color;
-    Color diffuse_color;
-    Color specular_color;
-    Color emissive_color;
-
-    float specular_exponent;
-    float optical_density;
-    float dissolve_factor;
-    int illumination_model;
+    Color ambient_color = Color{0.2f, 0.2f, 0.2f, 1.0f};
+    Color diffuse_color = Color{0.8f, 0.8f, 0.8f, 1.0f};
+    Color specular_color = Color{1.0f, 1.0f, 1.0f, 1.0f};
+    Color emissive_color = Color{0.0f, 0.0f, 0.0f, 1.0f};
+
+    float specular_exponent = 0.0f;
+    float optical_density = 1.0f;
+    float dissolve_factor = 1.0f;  //opacity, anything below 1 goes through the translucent pass
+    int illumination_model = 1;
 };
 
 struct Face { 
@@ -50,19 +53,46 @@ struct Face {
     Face(Material& material) : face_material(material) {}
 };
 
+//a run of neighbouring faces small enough to cull as one unit, faces [face_offset, face_offset + triangle_count)
+//index a local vertex list so every shared vertex is only fetched and transformed once per meshlet
+const int MESHLET_MAX_VERTICES = 128;
+const int MESHLET_MAX_TRIANGLES = 256;
+
+struct Meshlet {
+    int vertex_offset;    //into the model's meshlet_vertices
+    int vertex_count;
+    int face_offset;      //first face, also where its local indices start in meshlet_triangles (three per face)
+    int triangle_count;
+
+    Vector3 center;       //bounding sphere
+    float radius;
+    Vector3 cone_axis;    //average facing direction
+    float cone_cutoff;    //sine of how far the faces spread from the axis, 1 means it can never be back face culled
+};
+
 //----------------------------------------Model_Class-----------------------------
 class Model {
     private:
         std::vector<Vector3> vertices;
-        std::vector<std::vector<int>> vertices_info;
         std::vector<Face> faces;
         std::vector<Vector3> normals;
         std::vector<Material> materials;
         std::vector<Vertex_Texture> textures;
         std::string texture_file_path;
+        Mesh_Adjacency adjacency;  //which face corners touch each vertex
 
         Vector3 center_of_origin;
 
+        std::vector<Meshlet> meshlets;
+        std::vector<int> meshlet_vertices;       //global vertex index for every local slot
+        std::vector<uint8_t> meshlet_triangles;  //local vertex slot for every face corner
+
+        bool occluder = false;  //always rasterized into the occlusion buffer when set
+        uint64_t revision = next_revision();  //bumped by anything that can change how the model looks
+        bool vertex_streams_released = false;
+
+        bool require_vertex_streams(const char* action) const; //false, with an error, once the streams are gone
+
     public:
         void find_origin();
         
@@ -72,16 +102,39 @@ class Model {
         void scale(float scalar);
 
         const std::vector<Vector3>& get_vertices() const;
-        const std::vector<std::vector<int>>& get_vertex_info() const;
+        const Mesh_Adjacency& get_adjacency() const { return adjacency; }
         const std::vector<Face>& get_faces() const;
         const std::vector<Vector3>& get_normals() const;
         std::vector<Material> get_materials() const;
         const std::vector<Vertex_Texture>& get_textures() const;
+        Material* find_material(const std::string& name); //counts as a change when found, the caller may edit it
+        const Material* find_material(const std::string& name) const; //lookups only, leaves the revision alone
+        //write access for deformers like skinning, call update_meshlet_bounds() once they are done
+        std::vector<Vector3>& get_mutable_vertices() { mark_changed(); return vertices; }
+        std::vector<Vector3>& get_mutable_normals() { mark_changed(); return normals; }
+        uint64_t get_revision() const { return revision; }
+        void mark_changed() { revision = next_revision(); } //for edits the model cannot see, like a material changed through a pointer kept from earlier
 
         const Vector3& get_center_of_origin() const;
+        const std::vector<Meshlet>& get_meshlets() const;
+        const std::vector<int>& get_meshlet_vertices() const;
+        const std::vector<uint8_t>& get_meshlet_triangles() const;
+
+        void get_bounds(Vector3& bounds_min, Vector3& bounds_max) const;
+        bool has_translucent_materials() const;
+        bool is_occluder() const { return occluder; }
+        void set_occluder(bool is_occluder) { occluder = is_occluder; }
+
+        void build_adjacency(); //once every face is in, before anything asks for get_adjacency
+        //frees the float positions, normals and texture coordinates once a Quantized_Mesh holds them, after this the model
+        //can only be drawn through rasterize_quantized_model. faces, adjacency, meshlets and materials stay, but the model
+        //is frozen: transforms, meshlet and adjacency rebuilds, the BVH and skinning all refuse it
+        void release_vertex_streams();
+        bool has_vertex_streams() const { return !vertex_streams_released; }
+        void build_meshlets();
+        void update_meshlet_bounds(); //only needed after non rigid changes, the transforms above keep the bounds current
 
         void add_vertex(Vector3 vertex);
-        void add_vertex_face_info(int vertex_index, int face_index);
         void add_face(Face face);
         void add_normal(Vector3 normal);
         void add_material(Material material);
@@ -0,0 +1,159 @@
+#include "Occlusion_Culler.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+    //twice the signed area of (a, b, p), positive when p is on the inner side of edge a -> b for the winding passed in
+    float edge_function(const Vector3& a, const Vector3& b, float x, float y) {
+        return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+    }
+}
+
+Occlusion_Culler::Occlusion_Culler(int width, int height)
+    : width(width), height(height), depth(width * height, std::numeric_limits<float>::max()), near_plane(0.0f),
+      has_occluders(false), tested_count(0), rejected_count(0), culling_time_ms(0.0f) {}
+
+void Occlusion_Culler::begin_frame(const Camera& camera) {
+    std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+    all_transforms = camera.get_projection_matrix() * camera.get_view_matrix();
+    camera_position = camera.get_position();
+    camera_forward = camera.get_forward();
+    near_plane = camera.get_near_plane();
+    frustum = camera.get_viewing_volume();
+    has_occluders = false;
+    tested_count = 0;
+    rejected_count = 0;
+    culling_time_ms = 0.0f;
+}
+
+bool Occlusion_Culler::project(const Vector3& world_point, Vector3& screen_point) const {
+    //z holds the real distance in front of the camera instead of the rasterizer's depth, it is linear so min and max over a box mean something
+    float distance = dot_product(camera_forward, world_point - camera_position);
+    if (distance <= near_plane) {
+        return false;  //behind the camera the projection flips, the caller has to treat this as unknown
+    }
+    Vector4 clip = matrix_transform(all_transforms, to_vector4(world_point));
+    screen_point = Vector3(
+        (clip.x / clip.w + 1.0f) * width / 2,
+        (1.0f - clip.y / clip.w) * height / 2,
+        distance
+    );
+    return true;
+}
+
+void Occlusion_Culler::add_occluder(const Model& model) {
+    if (!model.has_vertex_streams()) {
+        return;  //nothing to rasterize, leaving it out only makes the culling more conservative
+    }
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<Vector3>& vertices = model.get_vertices();
+    for (const auto& meshlet : model.get_meshlets()) {
+        if (!frustum.intersects_sphere(meshlet.center, meshlet.radius)) {
+            continue;
+        }
+        for (int face_index = meshlet.face_offset; face_index < meshlet.face_offset + meshlet.triangle_count; ++face_index) {
+            const Face& face = model.get_faces()[face_index];
+            Vector3 vertex_0, vertex_1, vertex_2;
+            if (project(vertices[face.vertex_index[0]], vertex_0)
+                && project(vertices[face.vertex_index[1]], vertex_1)
+                && project(vertices[face.vertex_index[2]], vertex_2)) {
+                rasterize_occluder_triangle(vertex_0, vertex_1, vertex_2);
+            }
+        }
+    }
+    has_occluders = true;
+    culling_time_ms += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Occlusion_Culler::rasterize_occluder_triangle(const Vector3& vertex_0, const Vector3& vertex_1, const Vector3& vertex_2) {
+    float area = edge_function(vertex_0, vertex_1, vertex_2.x, vertex_2.y);
+    if (area == 0.0f) {
+        return;
+    }
+    //flip to one winding so "inside" is always the positive side of every edge
+    const Vector3& a = vertex_0;
+    const Vector3& b = area > 0.0f ? vertex_1 : vertex_2;
+    const Vector3& c = area > 0.0f ? vertex_2 : vertex_1;
+    //the farthest corner stands in for the whole triangle, never nearer than any point it really covers
+    float triangle_depth = std::max({a.z, b.z, c.z});
+
+    int min_x = std::max(0, static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+    int min_y = std::max(0, static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+    int max_x = std::min(width - 1, static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}))));
+    int max_y = std::min(height - 1, static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}))));
+
+    for (int y = min_y; y <= max_y; ++y) {
+        for (int x = min_x; x <= max_x; ++x) {
+            float center_x = x + 0.5f;
+            float center_y = y + 0.5f;
+            bool covered = edge_function(a, b, center_x, center_y) >= 0.0f
+                        && edge_function(b, c, center_x, center_y) >= 0.0f
+                        && edge_function(c, a, center_x, center_y) >= 0.0f;
+            if (covered) {
+                float& pixel_depth = depth[y * width + x];
+                pixel_depth = std::min(pixel_depth, triangle_depth);
+            }
+        }
+    }
+}
+
+bool Occlusion_Culler::is_visible(const Vector3& bounds_min, const Vector3& bounds_max) {
+    if (!has_occluders) {
+        return true;
+    }
+    auto start = std::chrono::steady_clock::now();
+    tested_count++;
+
+    float min_x = std::numeric_limits<float>::max(), min_y = std::numeric_limits<float>::max();
+    float max_x = -std::numeric_limits<float>::max(), max_y = -std::numeric_limits<float>::max();
+    float nearest = std::numeric_limits<float>::max();
+    bool visible = false;
+    for (int corner = 0; corner < 8; ++corner) {
+        Vector3 world_corner(
+            corner & 1 ? bounds_max.x : bounds_min.x,
+            corner & 2 ? bounds_max.y : bounds_min.y,
+            corner & 4 ? bounds_max.z : bounds_min.z
+        );
+        Vector3 screen_corner;
+        if (!project(world_corner, screen_corner)) {
+            visible = true;  //the box reaches past the near plane, too close to say anything about
+            break;
+        }
+        min_x = std::min(min_x, screen_corner.x);
+        min_y = std::min(min_y, screen_corner.y);
+        max_x = std::max(max_x, screen_corner.x);
+        max_y = std::max(max_y, screen_corner.y);
+        nearest = std::min(nearest, screen_corner.z);
+    }
+
+    if (!visible) {
+        //grown by a pixel, occluders mark any pixel whose center they cover so their edges can reach half a pixel too far
+        int start_x = std::max(0, static_cast<int>(std::floor(min_x)) - 1);
+        int start_y = std::max(0, static_cast<int>(std::floor(min_y)) - 1);
+        int end_x = std::min(width - 1, static_cast<int>(std::ceil(max_x)) + 1);
+        int end_y = std::min(height - 1, static_cast<int>(std::ceil(max_y)) + 1);
+        //off the buffer entirely is the frustum test's call, not ours
+        visible = start_x > end_x || start_y > end_y;
+        //hidden only if every pixel under the box already has an occluder in front of its nearest point
+        for (int y = start_y; y <= end_y && !visible; ++y) {
+            for (int x = start_x; x <= end_x; ++x) {
+                if (depth[y * width + x] >= nearest) {
+                    visible = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!visible) {
+        rejected_count++;
+    }
+    culling_time_ms += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return visible;
+}
+
+void Occlusion_Culler::print_stats() const {
+    std::cout << "Occlusion: rejected " << rejected_count << " of " << tested_count
+              << " tested, " << culling_time_ms << "ms" << std::endl;
+}
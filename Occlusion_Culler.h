@@ -0,0 +1,56 @@
+/*
+File Description:
+- Software occlusion culling. A few big occluder models are rasterized into a
+- small depth buffer, then the screen space box of every other model (or
+- streamed chunk) is checked against it, anything that is behind the
+- occluders over its whole box gets skipped. The test is conservative, an
+- occluder triangle only writes its farthest depth and boxes are checked a
+- pixel wider than they project, so a visible object is never rejected.
+
+Important References:
+- https://www.intel.com/content/www/us/en/developer/articles/technical/masked-software-occlusion-culling.html
+*/
+
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+//Standard C Libraries
+#include <vector>   //depth buffer
+//Created Files
+#include "Camera.h"
+#include "Model.h"
+#include "Utilities.h"
+
+class Occlusion_Culler {
+    private:
+        int width;
+        int height;
+        std::vector<float> depth;   //distance along the camera forward, max float where nothing has been drawn
+        Matrix4 all_transforms;
+        Vector3 camera_position;
+        Vector3 camera_forward;
+        float near_plane;
+        Frustum frustum;
+        bool has_occluders;
+
+        int tested_count;
+        int rejected_count;
+        float culling_time_ms;  //occluder rasterizing and box tests together
+
+        bool project(const Vector3& world_point, Vector3& screen_point) const;
+        void rasterize_occluder_triangle(const Vector3& vertex_0, const Vector3& vertex_1, const Vector3& vertex_2);
+
+    public:
+        explicit Occlusion_Culler(int width = 128, int height = 128);
+
+        void begin_frame(const Camera& camera);
+        void add_occluder(const Model& model);
+        bool is_visible(const Vector3& bounds_min, const Vector3& bounds_max);
+
+        bool get_has_occluders() const { return has_occluders; }
+        int get_tested_count() const { return tested_count; }
+        int get_rejected_count() const { return rejected_count; }
+        float get_culling_time_ms() const { return culling_time_ms; }
+        void print_stats() const;
+};
+
+#endif
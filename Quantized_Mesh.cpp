@@ -0,0 +1,168 @@
+#include "Quantized_Mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+    const float POSITION_STEPS = 65535.0f;
+
+    int16_t to_snorm16(float value) {
+        return static_cast<int16_t>(std::lround(std::min(1.0f, std::max(-1.0f, value)) * 32767.0f));
+    }
+
+    float sign_not_zero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+uint32_t encode_octahedral(const Vector3& normal) {
+    //project onto the octahedron |x|+|y|+|z| = 1, then fold the lower half out over the corners of the square
+    float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (length == 0.0f) {
+        return 0;
+    }
+    float x = normal.x / length;
+    float y = normal.y / length;
+    if (normal.z < 0.0f) {
+        float folded_x = (1.0f - std::fabs(y)) * sign_not_zero(x);
+        float folded_y = (1.0f - std::fabs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+    return static_cast<uint16_t>(to_snorm16(x)) | (static_cast<uint32_t>(static_cast<uint16_t>(to_snorm16(y))) << 16);
+}
+
+Vector3 decode_octahedral(uint32_t encoded) {
+    float x = static_cast<int16_t>(encoded & 0xFFFF) / 32767.0f;
+    float y = static_cast<int16_t>(encoded >> 16) / 32767.0f;
+    Vector3 normal(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+    //unfold the lower half
+    float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    float length = std::sqrt(dot_product(normal, normal));
+    return length > 0.0f ? normal / length : normal;
+}
+
+uint16_t float_to_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent >= 31) {
+        //too big (or already inf/nan), keep nan a nan
+        bool is_nan = ((bits >> 23) & 0xFF) == 0xFF && mantissa != 0;
+        return sign | 0x7C00 | (is_nan ? 0x200 : 0);
+    }
+    if (exponent <= 0) {
+        //subnormal half, or too small and it rounds to zero
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half_mantissa = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) {
+            half_mantissa++;
+        }
+        return sign | static_cast<uint16_t>(half_mantissa);
+    }
+    //round to nearest, a carry out of the mantissa bumps the exponent which is exactly right
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) {
+        half++;
+    }
+    return sign | static_cast<uint16_t>(std::min<uint32_t>(half, 0x7C00));
+}
+
+float half_to_float(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            //subnormal, shift it up until it is normal in float terms
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void Quantized_Mesh::build(const Model& model) {
+    if (!model.has_vertex_streams()) {
+        std::cerr << "Cannot quantize a model whose vertex streams were released, keeping the old copy" << std::endl;
+        return;
+    }
+    const std::vector<Vector3>& vertices = model.get_vertices();
+    Vector3 bounds_max;
+    if (vertices.empty()) {
+        bounds_min = bounds_max = Vector3();
+    } else {
+        bounds_min = bounds_max = vertices[0];
+        for (const auto& vertex : vertices) {
+            bounds_min = Vector3(std::min(bounds_min.x, vertex.x), std::min(bounds_min.y, vertex.y), std::min(bounds_min.z, vertex.z));
+            bounds_max = Vector3(std::max(bounds_max.x, vertex.x), std::max(bounds_max.y, vertex.y), std::max(bounds_max.z, vertex.z));
+        }
+    }
+    Vector3 extent = bounds_max - bounds_min;
+    step = Vector3(extent.x / POSITION_STEPS, extent.y / POSITION_STEPS, extent.z / POSITION_STEPS);
+
+    positions.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        Vector3 offset = vertices[i] - bounds_min;
+        //flat axes (a plane, a single point) have a step of 0 and always decode to the minimum
+        positions[i].x = static_cast<uint16_t>(step.x > 0.0f ? std::lround(offset.x / step.x) : 0);
+        positions[i].y = static_cast<uint16_t>(step.y > 0.0f ? std::lround(offset.y / step.y) : 0);
+        positions[i].z = static_cast<uint16_t>(step.z > 0.0f ? std::lround(offset.z / step.z) : 0);
+    }
+
+    normals.resize(model.get_normals().size());
+    for (size_t i = 0; i < normals.size(); ++i) {
+        normals[i] = encode_octahedral(model.get_normals()[i]);
+    }
+
+    textures.resize(model.get_textures().size());
+    for (size_t i = 0; i < textures.size(); ++i) {
+        textures[i].start = float_to_half(model.get_textures()[i].start);
+        textures[i].end = float_to_half(model.get_textures()[i].end);
+    }
+}
+
+size_t Quantized_Mesh::get_memory_bytes() const {
+    return positions.size() * sizeof(Quantized_Position) + normals.size() * sizeof(uint32_t) + textures.size() * sizeof(Half_Texture);
+}
+
+size_t Quantized_Mesh::get_float_memory_bytes(const Model& model) {
+    return model.get_vertices().size() * sizeof(Vector3) + model.get_normals().size() * sizeof(Vector3) +
+           model.get_textures().size() * sizeof(Vertex_Texture);
+}
+
+float Quantized_Mesh::get_max_position_error() const {
+    return 0.5f * std::max(step.x, std::max(step.y, step.z));
+}
+
+void Quantized_Mesh::print_stats(const Model& model) const {
+    size_t float_bytes = get_float_memory_bytes(model);
+    size_t quantized_bytes = get_memory_bytes();
+    std::cout << "Quantized vertex data: " << float_bytes / 1024.0 << " KB -> " << quantized_bytes / 1024.0 << " KB ("
+              << (float_bytes > 0 ? 100.0 * (float_bytes - quantized_bytes) / float_bytes : 0.0) << "% saved), max position error "
+              << get_max_position_error() << std::endl;
+}
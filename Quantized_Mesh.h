@@ -0,0 +1,67 @@
+/*
+File Description:
+- Compact copy of a model's vertex data for when memory or bandwidth is the
+- limit rather than math:
+-   positions: 16 bits per axis relative to the model's bounds (6 bytes instead of 12)
+-   normals:   octahedron mapped into two 16 bit values (4 bytes instead of 12)
+-   texcoords: half floats (4 bytes instead of 8)
+- Decoding happens on the fly in the vertex stage, Quantized_Vertex_Source
+- plugs it into the raster pipeline in place of the model's float data.
+- Faces, meshlets and materials still come from the model, only the vertex
+- streams are replaced. Like the meshlet bounds it has to be rebuilt after the
+- model is transformed. Once Model::release_vertex_streams has run there is
+- nothing to rebuild it from, so a released model is frozen where it was and
+- its transforms refuse to run.
+Important References:
+- https://jcgt.org/published/0003/02/01/ (octahedron normal vectors)
+*/
+
+#ifndef QUANTIZED_MESH_H
+#define QUANTIZED_MESH_H
+//Standard C Libraries
+#include <vector>   //vertex streams
+#include <cstdint>  //packed types
+#include <cstddef>  //size_t
+//Created Files
+#include "Model.h"
+
+struct Quantized_Position {
+    uint16_t x, y, z;
+};
+
+struct Half_Texture {
+    uint16_t start, end;
+};
+
+uint32_t encode_octahedral(const Vector3& normal);
+Vector3 decode_octahedral(uint32_t encoded);
+uint16_t float_to_half(float value);
+float half_to_float(uint16_t half);
+
+class Quantized_Mesh {
+    private:
+        Vector3 bounds_min;
+        Vector3 step;  //world size of one quantization step on each axis
+        std::vector<Quantized_Position> positions;
+        std::vector<uint32_t> normals;
+        std::vector<Half_Texture> textures;
+
+    public:
+        void build(const Model& model);
+
+        Vector3 get_position(int vertex_index) const {
+            const Quantized_Position& position = positions[vertex_index];
+            return Vector3(bounds_min.x + position.x * step.x, bounds_min.y + position.y * step.y, bounds_min.z + position.z * step.z);
+        }
+        Vector3 get_normal(int normal_index) const { return decode_octahedral(normals[normal_index]); }
+        Vertex_Texture get_texture(int texture_index) const {
+            return Vertex_Texture{half_to_float(textures[texture_index].start), half_to_float(textures[texture_index].end)};
+        }
+
+        size_t get_memory_bytes() const;
+        static size_t get_float_memory_bytes(const Model& model);  //what the same streams take in the model
+        float get_max_position_error() const;  //half a step on the coarsest axis
+        void print_stats(const Model& model) const;
+};
+
+#endif
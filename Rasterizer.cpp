@@ -0,0 +1,32 @@
+#include "Rasterizer.h"
+#include <cmath>
+
+Vector3 project_to_screen(const Vector3& world_vertex, const Matrix4& all_transforms, int width, int height) {
+    //transform so the camera is at 0,0,0 and project the coned frustrum so it is in a cube shape, this will give the
+    //appearance of objects closer to camera being bigger and objects farther away being smaller
+    Vector4 vertex_4 = matrix_transform(all_transforms, to_vector4(world_vertex));
+
+    // normalizes the cube to be a 1 by 1 by 1
+    Vector3 vertex = {vertex_4.x / vertex_4.w, vertex_4.y / vertex_4.w, vertex_4.z / vertex_4.w};
+
+    //maps the 1 by 1 by cuber to the screen, the projection leaves w negative in front of the camera so the
+    //normalized z shrinks with distance, flipping it gives a depth that grows with distance and stays linear across the screen
+    return Vector3(
+        (vertex.x + 1.0f) * width / 2,
+        (1.0f - vertex.y) * height / 2,
+        -vertex.z
+    );
+}
+
+bool is_meshlet_visible(const Meshlet& meshlet, const Frustum& frustum, const Vector3& camera_position, bool backface_culling) {
+    if (!frustum.intersects_sphere(meshlet.center, meshlet.radius)) {
+        return false;
+    }
+    if (!backface_culling) {
+        return true;
+    }
+    //the camera sits inside the cone behind the meshlet, every face in it points away
+    Vector3 to_center = meshlet.center - camera_position;
+    float distance = std::sqrt(dot_product(to_center, to_center));
+    return dot_product(to_center, meshlet.cone_axis) < meshlet.cone_cutoff * distance + meshlet.radius;
+}
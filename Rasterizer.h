@@ -0,0 +1,333 @@
+/*
+File Description:
+- The one raster pipeline every shading mode goes through. It is a template over
+- two policies, picked at compile time:
+-   Vertex policy:  what gets computed once per meshlet vertex (nothing, lighting, ...)
+-   Shading policy: what gets set up once per face and what each covered pixel writes
+- Each combination becomes its own function, so a mode only pays for the
+- attributes it actually uses and the inner pixel loop has no mode checks or
+- virtual calls in it. Adding a mode means writing a new policy, not another
+- copy of the loop.
+- Vertex positions and normals are read through a vertex source, the model's
+- own float data by default or a Quantized_Mesh decoded on the fly.
+- Works on a Frame_Buffer and a Camera only, nothing here needs SDL.
+*/
+
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+//Standard C Libraries
+#include <algorithm>  //bounding box clamps
+#include <cstdint>    //packed colors
+#include <iostream>   //released vertex streams
+//Created Files
+#include "Utilities.h"
+#include "Model.h"
+#include "Camera.h"
+#include "Frame_Buffer.h"
+#include "Quantized_Mesh.h"
+
+//per draw inputs shared by every policy
+struct Raster_Settings {
+    Vector3 light_direction;
+    bool backface_culling = true; //skip meshlets facing fully away, only safe for closed meshes
+};
+
+//world space to pixel x,y plus the depth value the depth buffer compares
+Vector3 project_to_screen(const Vector3& world_vertex, const Matrix4& all_transforms, int width, int height);
+//frustum test on the bounding sphere, then the normal cone when backface culling is on
+bool is_meshlet_visible(const Meshlet& meshlet, const Frustum& frustum, const Vector3& camera_position, bool backface_culling);
+
+//------Vertex Sources------
+
+//the model's own float streams
+struct Model_Vertex_Source {
+    const Model* model;
+
+    const Model& get_model() const { return *model; }
+    const Vector3& get_position(int vertex_index) const { return model->get_vertices()[vertex_index]; }
+    const Vector3& get_normal(int normal_index) const { return model->get_normals()[normal_index]; }
+};
+
+//compressed streams, decoded one vertex at a time as the pipeline asks for them
+struct Quantized_Vertex_Source {
+    const Model* model;
+    const Quantized_Mesh* mesh;
+
+    const Model& get_model() const { return *model; }
+    Vector3 get_position(int vertex_index) const { return mesh->get_position(vertex_index); }
+    Vector3 get_normal(int normal_index) const { return mesh->get_normal(normal_index); }
+};
+
+//------Vertex Policies------
+
+//nothing per vertex, for modes that only look at the face
+struct No_Vertex_Attributes {
+    struct Attributes {};
+    template <typename Vertex_Source>
+    static Attributes fetch(const Vertex_Source&, int, const Raster_Settings&) { return Attributes(); }
+};
+
+//diffuse brightness from the smoothed vertex normal
+struct Vertex_Lighting {
+    struct Attributes {
+        float brightness;
+    };
+    template <typename Vertex_Source>
+    static Attributes fetch(const Vertex_Source& source, int vertex_index, const Raster_Settings& settings) {
+        //smooth the normal by averaging every normal this vertex was given in the file, one per face corner it is used by
+        const Mesh_Adjacency& adjacency = source.get_model().get_adjacency();
+        const std::vector<Face>& faces = source.get_model().get_faces();
+        Vector3 normal = Vector3();
+        for (const int* corner = adjacency.corners_begin(vertex_index); corner != adjacency.corners_end(vertex_index); ++corner) {
+            normal = normal + source.get_normal(faces[get_corner_face(*corner)].normal_index[get_corner_slot(*corner)]);
+        }
+        normal = normal / adjacency.get_corner_count(vertex_index);
+        return Attributes{std::min(1.0f, std::max(0.0f, dot_product(settings.light_direction, normal)))};
+    }
+};
+
+//------Shading Policies------
+
+//one lit color for the whole face
+struct Flat_Shading {
+    static const bool WRITES_COLOR = true;
+    static const bool TRANSLUCENT = false;
+    static const bool DEPTH_EQUAL_PASSES = false;
+    struct Face_State {
+        uint32_t color;
+        Color lit_color;
+    };
+    static bool draws_face(const Face& face) { return face.face_material.dissolve_factor >= 1.0f; }
+    template <typename Vertex_Source, typename Attributes>
+    static Face_State setup(const Vertex_Source& source, const Face& face, const Attributes&, const Attributes&, const Attributes&, const Raster_Settings& settings) {
+        float brightness = std::max(0.0f, dot_product(settings.light_direction, source.get_normal(face.normal_index[0])));
+        Color color = face.face_material.diffuse_color;
+        color.r *= brightness;
+        color.g *= brightness;
+        color.b *= brightness;
+        return Face_State{pack_color(color), color};
+    }
+    static uint32_t shade(const Face_State& state, int, int, const Vector3&, const Vector3&, const Vector3&) {
+        return state.color;
+    }
+    static Color shade_color(const Face_State& state, int, int, const Vector3&, const Vector3&, const Vector3&) {
+        return state.lit_color;
+    }
+};
+
+//vertex colors blended across the face, needs Vertex_Lighting
+struct Gouraud_Shading {
+    static const bool WRITES_COLOR = true;
+    static const bool TRANSLUCENT = false;
+    static const bool DEPTH_EQUAL_PASSES = false;
+    struct Face_State {
+        Color color_0, color_1, color_2;
+    };
+    static bool draws_face(const Face& face) { return face.face_material.dissolve_factor >= 1.0f; }
+    template <typename Vertex_Source>
+    static Face_State setup(const Vertex_Source&, const Face& face, const Vertex_Lighting::Attributes& corner_0, const Vertex_Lighting::Attributes& corner_1,
+                            const Vertex_Lighting::Attributes& corner_2, const Raster_Settings&) {
+        const Color& diffuse = face.face_material.diffuse_color;
+        return Face_State{diffuse * corner_0.brightness, diffuse * corner_1.brightness, diffuse * corner_2.brightness};
+    }
+    static Color shade_color(const Face_State& state, int x, int y, const Vector3& vertex_0, const Vector3& vertex_1, const Vector3& vertex_2) {
+        Vector3 weights = barycentric_interpolation_weights(x, y, vertex_0, vertex_1, vertex_2);
+        return state.color_0 * weights.z + state.color_1 * weights.x + state.color_2 * weights.y;
+    }
+    static uint32_t shade(const Face_State& state, int x, int y, const Vector3& vertex_0, const Vector3& vertex_1, const Vector3& vertex_2) {
+        return pack_color(shade_color(state, x, y, vertex_0, vertex_1, vertex_2));
+    }
+};
+
+//fills the depth buffer and leaves color alone, for depth pre-passes
+struct Depth_Only {
+    static const bool WRITES_COLOR = false;
+    static const bool TRANSLUCENT = false;
+    static const bool DEPTH_EQUAL_PASSES = false;
+    struct Face_State {};
+    static bool draws_face(const Face& face) { return face.face_material.dissolve_factor >= 1.0f; }
+    template <typename Vertex_Source, typename Attributes>
+    static Face_State setup(const Vertex_Source&, const Face&, const Attributes&, const Attributes&, const Attributes&, const Raster_Settings&) {
+        return Face_State();
+    }
+};
+
+//the shaded pass after a Depth_Only pre-pass of the same models. the pre-pass already left each visible pixel's exact depth
+//in the buffer (both passes project and interpolate the same way), so equal has to pass and everything behind it gets skipped
+template <typename Base_Shading>
+struct After_Depth_Prepass : Base_Shading {
+    static const bool DEPTH_EQUAL_PASSES = true;
+};
+
+//weighted blended transparency on top of another shading policy's colors, for faces whose material dissolve is below 1.
+//has to run after every opaque face is in: it tests against their depth without writing any, and adds to the
+//frame's accumulation buffers instead of overwriting, so the faces can come in any order. Frame_Buffer::resolve_translucency finishes it
+template <typename Base_Shading>
+struct Translucent_Shading {
+    static const bool WRITES_COLOR = false;
+    static const bool TRANSLUCENT = true;
+    static const bool DEPTH_EQUAL_PASSES = false;
+    struct Face_State {
+        typename Base_Shading::Face_State base;
+        float alpha;
+    };
+    static bool draws_face(const Face& face) { return face.face_material.dissolve_factor < 1.0f && face.face_material.dissolve_factor > 0.0f; }
+    template <typename Vertex_Source, typename Attributes>
+    static Face_State setup(const Vertex_Source& source, const Face& face, const Attributes& corner_0, const Attributes& corner_1, const Attributes& corner_2,
+                            const Raster_Settings& settings) {
+        return Face_State{Base_Shading::setup(source, face, corner_0, corner_1, corner_2, settings), face.face_material.dissolve_factor};
+    }
+    static Color shade_color(const Face_State& state, int x, int y, const Vector3& vertex_0, const Vector3& vertex_1, const Vector3& vertex_2) {
+        return Base_Shading::shade_color(state.base, x, y, vertex_0, vertex_1, vertex_2);
+    }
+};
+
+//------Pipeline------
+
+//the pixel loop of rasterize_triangle over one already clipped box
+template <typename Shading_Policy>
+void fill_triangle_box(Frame_Buffer& frame, int min_x, int min_y, int max_x, int max_y, const Vector3& vertex_0, const Vector3& vertex_1,
+                       const Vector3& vertex_2, const typename Shading_Policy::Face_State& state) {
+    for (int y = min_y; y <= max_y; ++y) {
+        for (int x = min_x; x <= max_x; ++x) {
+            if (is_point_inside_triangle(x, y, vertex_0, vertex_1, vertex_2)) {//check if the pixel from the area to render is in the triangle
+                float z = barycentric_interpolation_z_value(x, y, vertex_0, vertex_1, vertex_2);//determine z depth on all points as only the vertexes have a z value
+                //check the z_buffer if its on top render that pixel and store it, after a pre-pass the visible pixel holds exactly this z
+                if (Shading_Policy::DEPTH_EQUAL_PASSES ? z <= frame.depth_at(x, y) : z < frame.depth_at(x, y)) {
+                    if constexpr (Shading_Policy::TRANSLUCENT) {
+                        frame.accumulate_translucent(x, y, z, Shading_Policy::shade_color(state, x, y, vertex_0, vertex_1, vertex_2), state.alpha);
+                    } else {
+                        frame.depth_at(x, y) = z;
+                        if constexpr (Shading_Policy::WRITES_COLOR) {
+                            frame.color[y * frame.width + x] = Shading_Policy::shade(state, x, y, vertex_0, vertex_1, vertex_2) | OPAQUE_ALPHA;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//fills one screen space triangle, vertices are what project_to_screen returns
+template <typename Shading_Policy>
+void rasterize_triangle(Frame_Buffer& frame, const Vector3& vertex_0, const Vector3& vertex_1, const Vector3& vertex_2,
+                        const typename Shading_Policy::Face_State& state) {
+    //if minimizes the check area to be on the screen (and inside the scissor) and no bigger than the triangle this is for efficenacy
+    int min_x = std::max(frame.scissor.min_x, std::min({static_cast<int>(vertex_0.x), static_cast<int>(vertex_1.x), static_cast<int>(vertex_2.x)}));
+    int min_y = std::max(frame.scissor.min_y, std::min({static_cast<int>(vertex_0.y), static_cast<int>(vertex_1.y), static_cast<int>(vertex_2.y)}));
+    int max_x = std::min({frame.width - 1, frame.scissor.max_x, std::max({static_cast<int>(vertex_0.x), static_cast<int>(vertex_1.x), static_cast<int>(vertex_2.x)})});
+    int max_y = std::min({frame.height - 1, frame.scissor.max_y, std::max({static_cast<int>(vertex_0.y), static_cast<int>(vertex_1.y), static_cast<int>(vertex_2.y)})});
+    if (frame.scissor_rects.empty()) {
+        fill_triangle_box<Shading_Policy>(frame, min_x, min_y, max_x, max_y, vertex_0, vertex_1, vertex_2, state);
+        return;
+    }
+    //a scissor made of several rects, the box gets cut down to each one it reaches
+    for (const Pixel_Rect& rect : frame.scissor_rects) {
+        fill_triangle_box<Shading_Policy>(frame, std::max(min_x, rect.min_x), std::max(min_y, rect.min_y), std::min(max_x, rect.max_x),
+                                          std::min(max_y, rect.max_y), vertex_0, vertex_1, vertex_2, state);
+    }
+}
+
+//one viewpoint for rasterize_model_views, every view draws into its own target
+struct Raster_View {
+    const Camera* camera;
+    Frame_Buffer* frame;
+};
+
+const int MAX_RASTER_VIEWS = 8; //enough for a cube map or a stereo pair plus previews
+
+//culls, transforms and fills a whole model meshlet by meshlet for several cameras at once,
+//everything that does not depend on the camera (vertex attributes, face setup) is done once and shared by all views
+template <typename Vertex_Policy, typename Shading_Policy, typename Vertex_Source>
+void rasterize_source_views(const Raster_View* views, int view_count, const Vertex_Source& source, const Raster_Settings& settings) {
+    const Model& model = source.get_model();
+    view_count = std::min(view_count, MAX_RASTER_VIEWS);
+    Matrix4 all_transforms[MAX_RASTER_VIEWS];
+    Frustum frustums[MAX_RASTER_VIEWS];
+    for (int view = 0; view < view_count; ++view) {
+        all_transforms[view] = views[view].camera->get_projection_matrix() * views[view].camera->get_view_matrix();
+        frustums[view] = views[view].camera->get_viewing_volume();
+        if constexpr (Shading_Policy::TRANSLUCENT) {
+            //the weights need to know where the depth range starts and ends for this camera
+            const Camera& camera = *views[view].camera;
+            float depth_near = project_to_screen(camera.get_position() + camera.get_forward() * camera.get_near_plane(), all_transforms[view], 1, 1).z;
+            float depth_far = project_to_screen(camera.get_position() + camera.get_forward() * camera.get_far_plane(), all_transforms[view], 1, 1).z;
+            views[view].frame->begin_translucency(depth_near, depth_far);
+        }
+    }
+    const std::vector<int>& meshlet_vertices = model.get_meshlet_vertices();
+    const std::vector<uint8_t>& meshlet_triangles = model.get_meshlet_triangles();
+    Vector3 projected[MESHLET_MAX_VERTICES];
+    typename Vertex_Policy::Attributes attributes[MESHLET_MAX_VERTICES];
+    typename Shading_Policy::Face_State face_states[MESHLET_MAX_TRIANGLES];
+    bool face_drawn[MESHLET_MAX_TRIANGLES];
+
+    for (const auto& meshlet : model.get_meshlets()) {
+        //whole meshlets are thrown out before a single one of their vertices is read
+        bool visible[MAX_RASTER_VIEWS];
+        bool visible_anywhere = false;
+        for (int view = 0; view < view_count; ++view) {
+            visible[view] = is_meshlet_visible(meshlet, frustums[view], views[view].camera->get_position(), settings.backface_culling);
+            visible_anywhere = visible_anywhere || visible[view];
+        }
+        if (!visible_anywhere) {
+            continue;
+        }
+
+        //each shared vertex gets lit once here instead of once per face (and view) that uses it
+        for (int i = 0; i < meshlet.vertex_count; ++i) {
+            attributes[i] = Vertex_Policy::fetch(source, meshlet_vertices[meshlet.vertex_offset + i], settings);
+        }
+        for (int i = 0; i < meshlet.triangle_count; ++i) {
+            //opaque and translucent faces share meshlets, each pass only sets up its own
+            const Face& face = model.get_faces()[meshlet.face_offset + i];
+            face_drawn[i] = Shading_Policy::draws_face(face);
+            if (face_drawn[i]) {
+                const uint8_t* corners = &meshlet_triangles[(meshlet.face_offset + i) * 3];
+                face_states[i] = Shading_Policy::setup(source, face, attributes[corners[0]], attributes[corners[1]], attributes[corners[2]], settings);
+            }
+        }
+
+        for (int view = 0; view < view_count; ++view) {
+            if (!visible[view]) {
+                continue;
+            }
+            Frame_Buffer& frame = *views[view].frame;
+            for (int i = 0; i < meshlet.vertex_count; ++i) {
+                projected[i] = project_to_screen(source.get_position(meshlet_vertices[meshlet.vertex_offset + i]), all_transforms[view], frame.width, frame.height);
+            }
+            for (int i = 0; i < meshlet.triangle_count; ++i) {
+                if (!face_drawn[i]) {
+                    continue;
+                }
+                const uint8_t* corners = &meshlet_triangles[(meshlet.face_offset + i) * 3];
+                rasterize_triangle<Shading_Policy>(frame, projected[corners[0]], projected[corners[1]], projected[corners[2]], face_states[i]);
+            }
+        }
+    }
+}
+
+template <typename Vertex_Policy, typename Shading_Policy>
+void rasterize_model_views(const Raster_View* views, int view_count, const Model& model, const Raster_Settings& settings) {
+    if (!model.has_vertex_streams()) {
+        std::cerr << "Model vertex streams were released, draw it through rasterize_quantized_model" << std::endl;
+        return;
+    }
+    rasterize_source_views<Vertex_Policy, Shading_Policy>(views, view_count, Model_Vertex_Source{&model}, settings);
+}
+
+//the usual single camera case
+template <typename Vertex_Policy, typename Shading_Policy>
+void rasterize_model(Frame_Buffer& frame, const Camera& camera, const Model& model, const Raster_Settings& settings) {
+    Raster_View view{&camera, &frame};
+    rasterize_model_views<Vertex_Policy, Shading_Policy>(&view, 1, model, settings);
+}
+
+//single camera, vertex data decoded from a quantized copy of the model
+template <typename Vertex_Policy, typename Shading_Policy>
+void rasterize_quantized_model(Frame_Buffer& frame, const Camera& camera, const Model& model, const Quantized_Mesh& mesh, const Raster_Settings& settings) {
+    Raster_View view{&camera, &frame};
+    rasterize_source_views<Vertex_Policy, Shading_Policy>(&view, 1, Quantized_Vertex_Source{&model, &mesh}, settings);
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "Ray_Tracer.h"
+#include <algorithm>
+
+Ray_Tracer::Ray_Tracer(const Model& model, const BVH& bvh, const Vector3& light_direction, const Color& background_color)
+    : model(model), bvh(bvh), light_direction(light_direction), background_color(background_color) {}
+
+Color Ray_Tracer::trace(const Ray& ray, int depth) const {
+    Ray_Hit hit;
+    if (!bvh.intersect(ray, hit)) {
+        return background_color;
+    }
+    return shade(ray, hit, depth);
+}
+
+Color Ray_Tracer::shade(const Ray& ray, const Ray_Hit& hit, int depth) const {
+    const Face& face = model.get_faces()[hit.face_index];
+    const Material& material = face.face_material;
+    const std::vector<Vector3>& vertices = model.get_vertices();
+
+    const Vector3& vertex_0 = vertices[face.vertex_index[0]];
+    Vector3 hit_point = ray.origin + ray.direction * hit.distance;
+    Vector3 geometric_normal = normalize(cross_product(vertices[face.vertex_index[1]] - vertex_0, vertices[face.vertex_index[2]] - vertex_0));
+    if (dot_product(geometric_normal, ray.direction) > 0.0f) {
+        geometric_normal = -geometric_normal;  //faces are two sided, always use the side the ray came from
+    }
+
+    //lighting matches the flat rasterizer, the file normal of the first corner lights the whole face
+    const Vector3& face_normal = model.get_normals()[face.normal_index[0]];
+    float brightness = std::max(0.0f, dot_product(light_direction, face_normal));
+    if (brightness > 0.0f) {
+        Ray shadow_ray{hit_point + geometric_normal * 1e-3f, light_direction};
+        if (bvh.occluded(shadow_ray, std::numeric_limits<float>::max())) {
+            brightness = 0.0f;
+        }
+    }
+    Color color = material.diffuse_color * brightness;
+    color.a = 1.0f;
+
+    if (depth + 1 < MAX_DEPTH && material.illumination_model >= 3) {
+        Ray reflected_ray{hit_point + geometric_normal * 1e-3f, reflect(ray.direction, geometric_normal)};
+        Color reflected = trace(reflected_ray, depth + 1);
+        color.r += reflected.r * material.specular_color.r;
+        color.g += reflected.g * material.specular_color.g;
+        color.b += reflected.b * material.specular_color.b;
+    }
+    return color;
+}
+
+void Ray_Tracer::render(Frame_Buffer& frame, const Camera& camera, Thread_Pool& pool) const {
+    int tiles_x = (frame.width + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_y = (frame.height + TILE_SIZE - 1) / TILE_SIZE;
+
+    //tiles never overlap so workers write straight into the frame without locking
+    pool.parallel_for(tiles_x * tiles_y, [&](int tile_index) {
+        int tile_x = (tile_index % tiles_x) * TILE_SIZE;
+        int tile_y = (tile_index / tiles_x) * TILE_SIZE;
+        int tile_end_x = std::min(tile_x + TILE_SIZE, frame.width);
+        int tile_end_y = std::min(tile_y + TILE_SIZE, frame.height);
+
+        for (int y = tile_y; y < tile_end_y; y += 2) {
+            for (int x = tile_x; x < tile_end_x; x += 2) {
+                //one packet per 2x2 quad, neighbouring primary rays walk almost the same nodes
+                Ray_Packet packet;
+                int lane_x[PACKET_SIZE], lane_y[PACKET_SIZE];
+                for (int lane = 0; lane < PACKET_SIZE; ++lane) {
+                    lane_x[lane] = std::min(x + (lane & 1), frame.width - 1);
+                    lane_y[lane] = std::min(y + (lane >> 1), frame.height - 1);
+                    float ndc_x = (lane_x[lane] + 0.5f) * 2.0f / frame.width - 1.0f;
+                    float ndc_y = 1.0f - (lane_y[lane] + 0.5f) * 2.0f / frame.height;
+                    packet.set_ray(lane, camera.get_ray(ndc_x, ndc_y));
+                }
+                bvh.intersect_packet(packet);
+
+                for (int lane = 0; lane < PACKET_SIZE; ++lane) {
+                    if (x + (lane & 1) >= tile_end_x || y + (lane >> 1) >= tile_end_y) {
+                        continue;  //padding lane on an odd sized edge
+                    }
+                    Color color = background_color;
+                    if (packet.face_index[lane] != -1) {
+                        Ray primary{
+                            Vector3(packet.origin_x[lane], packet.origin_y[lane], packet.origin_z[lane]),
+                            Vector3(packet.direction_x[lane], packet.direction_y[lane], packet.direction_z[lane])
+                        };
+                        color = shade(primary, packet.get_hit(lane), 0);
+                    }
+                    frame.set_pixel(lane_x[lane], lane_y[lane], color);
+                }
+            }
+        }
+    });
+}
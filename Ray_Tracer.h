@@ -0,0 +1,42 @@
+/*
+File Description:
+- Reference quality render mode, traces the same camera view the rasterizer
+- draws. Primary rays are shot four at a time as 2x2 pixel packets, each hit
+- casts a shadow ray towards the light and materials with reflection turned on
+- (illum 3 and up in the MTL file) bounce a reflection ray. The frame is cut into
+- tiles that the thread pool renders in parallel.
+
+Important References:
+- https://paulbourke.net/dataformats/mtl/ (illumination models)
+*/
+
+#ifndef RAY_TRACER_H
+#define RAY_TRACER_H
+//Created Files
+#include "BVH.h"
+#include "Camera.h"
+#include "Frame_Buffer.h"
+#include "Model.h"
+#include "Thread_Pool.h"
+#include "Utilities.h"
+
+class Ray_Tracer {
+    private:
+        const Model& model;
+        const BVH& bvh;
+        Vector3 light_direction;  //points towards the light, same convention as Screen::light_direction
+        Color background_color;
+
+        Color shade(const Ray& ray, const Ray_Hit& hit, int depth) const;
+
+    public:
+        static const int TILE_SIZE = 16;
+        static const int MAX_DEPTH = 2;  //primary hit plus one reflection bounce
+
+        Ray_Tracer(const Model& model, const BVH& bvh, const Vector3& light_direction, const Color& background_color);
+
+        Color trace(const Ray& ray, int depth) const;
+        void render(Frame_Buffer& frame, const Camera& camera, Thread_Pool& pool) const;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "Resolution_Scaler.h"
+#include <algorithm>
+
+Resolution_Scaler::Resolution_Scaler(int max_width, int max_height, float frame_budget_ms,
+                                     float min_scale, float scale_step, int sample_count)
+    : max_width(max_width), max_height(max_height), frame_budget_ms(frame_budget_ms),
+      min_scale(min_scale), scale_step(scale_step), scale(1.0f), average_frame_time_ms(0.0f), sample_count(sample_count) {
+    frame_times_ms.reserve(sample_count);
+    frame_start = std::chrono::steady_clock::now();
+}
+
+void Resolution_Scaler::begin_frame() {
+    frame_start = std::chrono::steady_clock::now();
+}
+
+void Resolution_Scaler::end_frame() {
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - frame_start;
+    frame_times_ms.push_back(elapsed.count());
+    if (static_cast<int>(frame_times_ms.size()) < sample_count) {
+        return;
+    }
+
+    //only decide once a full window of samples is in, a single slow frame should not cause a jump
+    float total = 0.0f;
+    for (float frame_time : frame_times_ms) {
+        total += frame_time;
+    }
+    average_frame_time_ms = total / frame_times_ms.size();
+
+    if (average_frame_time_ms > frame_budget_ms) {
+        scale = std::max(min_scale, scale - scale_step);
+    } else if (average_frame_time_ms < frame_budget_ms * 0.8f) {
+        //the 20% headroom stops the scale from bouncing between two steps every window
+        scale = std::min(1.0f, scale + scale_step);
+    }
+    frame_times_ms.clear();
+}
+
+int Resolution_Scaler::get_render_width() const {
+    return std::max(1, static_cast<int>(max_width * scale));
+}
+
+int Resolution_Scaler::get_render_height() const {
+    return std::max(1, static_cast<int>(max_height * scale));
+}
@@ -0,0 +1,40 @@
+/*
+File Description:
+- Watches how long recent frames took and picks the internal render resolution
+- that keeps the frame time inside a budget. Heavy frames drop the resolution,
+- cheap frames raise it back up towards the window size.
+*/
+
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+//Standard C Libraries
+#include <chrono>  //frame timing
+#include <vector>  //recent frame times
+
+class Resolution_Scaler {
+    private:
+        int max_width;
+        int max_height;
+        float frame_budget_ms;  //the frame time we are trying to hold
+        float min_scale;        //never render smaller than this fraction of the window
+        float scale_step;       //how much the scale moves per adjustment
+        float scale;
+        float average_frame_time_ms; //average of the last full window of samples
+        int sample_count;       //how many frames get averaged before deciding
+        std::vector<float> frame_times_ms;
+        std::chrono::steady_clock::time_point frame_start;
+
+    public:
+        Resolution_Scaler(int max_width, int max_height, float frame_budget_ms,
+                          float min_scale = 0.25f, float scale_step = 0.05f, int sample_count = 10);
+
+        void begin_frame();
+        void end_frame();
+
+        float get_scale() const { return scale; }
+        int get_render_width() const;
+        int get_render_height() const;
+        float get_average_frame_time() const { return average_frame_time_ms; }
+};
+
+#endif
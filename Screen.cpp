@@ -1,209 +1,333 @@
 #include "Screen.h"
 #include "Model.h"
+#include "Ray_Tracer.h"
 
-Screen::Screen() {
+const Color BACKGROUND_COLOR = Color{115 / 255.0f, 155 / 255.0f, 155 / 255.0f, 1.0f};
+
+Screen::Screen() : render_texture(nullptr), texture_width(0), texture_height(0), frame_arena(256 * 1024) {
     SDL_Init(SDL_INIT_VIDEO);
     SDL_CreateWindowAndRenderer(SCREEN_WIDTH, SCREEN_HEIGHT, 0, &window, &renderer);
-    for (int i = 0; i < SCREEN_WIDTH; ++i) {
-        for (int j = 0; j < SCREEN_HEIGHT; ++j) {
-            z_buffer[i][j] = std::numeric_limits<float>::max();
-        }
-    }
+    set_render_resolution(SCREEN_WIDTH, SCREEN_HEIGHT);
 }
 
 Screen::~Screen() {
+    if (render_texture) {
+        SDL_DestroyTexture(render_texture);
+    }
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
 
+void Screen::set_render_resolution(int width, int height) {
+    frame.resize(width, height);
+}
+
 void Screen::clear_display() {
-    SDL_SetRenderDrawColor(renderer, 115,155,155, 255);
-    SDL_RenderClear(renderer);
-    for (int i = 0; i < SCREEN_WIDTH; ++i) {
-        for (int j = 0; j < SCREEN_HEIGHT; ++j) {
-            z_buffer[i][j] = std::numeric_limits<float>::max();
+    frame.clear(pack_color(BACKGROUND_COLOR));
+    retained_frame = false;
+    upload_rect = Pixel_Rect{0, 0, frame.width - 1, frame.height - 1};
+    occlusion_culler.begin_frame(camera);
+    //last frame's scratch data is dead now, the blocks stay around for this one
+    frame_arena.reset();
+    translucent_draws.clear();
+}
+
+void Screen::present() {
+    draw_translucent();
+    //the texture only gets recreated when the render resolution actually changed
+    if (!render_texture || texture_width != frame.width || texture_height != frame.height) {
+        if (render_texture) {
+            SDL_DestroyTexture(render_texture);
+        }
+        render_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, frame.width, frame.height);
+        SDL_SetTextureScaleMode(render_texture, SDL_ScaleModeLinear);
+        //the frame is the whole picture, copy it over whatever the backbuffer holds instead of blending with it
+        SDL_SetTextureBlendMode(render_texture, SDL_BLENDMODE_NONE);
+        texture_width = frame.width;
+        texture_height = frame.height;
+        upload_rect = Pixel_Rect{0, 0, frame.width - 1, frame.height - 1};
+    }
+    //the texture keeps the last frame, only the part that was drawn again has to go up
+    upload_rect.max_x = std::min(upload_rect.max_x, frame.width - 1);
+    upload_rect.max_y = std::min(upload_rect.max_y, frame.height - 1);
+    if (!upload_rect.is_empty()) {
+        SDL_Rect region{upload_rect.min_x, upload_rect.min_y, upload_rect.max_x - upload_rect.min_x + 1, upload_rect.max_y - upload_rect.min_y + 1};
+        SDL_UpdateTexture(render_texture, &region, frame.color.data() + upload_rect.min_y * frame.width + upload_rect.min_x, frame.width * sizeof(uint32_t));
+    }
+    //anything drawn without going through render_scene gets the whole frame uploaded, like before
+    upload_rect = Pixel_Rect{0, 0, std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+    //a null destination rect stretches the render resolution over the whole window
+    SDL_RenderCopy(renderer, render_texture, nullptr, nullptr);
+    SDL_RenderPresent(renderer);
+}
+
+void Screen::capture(Frame_Capture& frame_capture) {
+    //has to come after present, the color buffer gets traded for a recycled one that may hold an old frame or nothing
+    int width = frame.width;
+    int height = frame.height;
+    if (retained_frame) {
+        //render_scene patches this frame into the next one, so it has to stay put and the capture buffer goes out instead.
+        //an idle scene leaves every recycled buffer current and copies nothing at all
+        if (capture_buffer.size() != frame.color.size()) {
+            capture_buffer.resize(frame.color.size());
+            capture_buffer_revision = 0;
+        }
+        dirty_regions.get_rects_changed_since(capture_buffer_revision, capture_rects);
+        for (const Pixel_Rect& rect : capture_rects) {
+            frame.copy_color_rect(capture_buffer, rect);
         }
+        capture_buffer_revision = dirty_regions.get_frame_revision();
+        frame_capture.submit(capture_buffer, width, height, &capture_buffer_revision);
+        return;
     }
+    frame_capture.submit(frame.color, width, height);
+    frame.color.resize(width * height);
 }
 
-void Screen::input() {
+bool Screen::input() {
+    //returns false once the window is closed, the caller leaves its loop so everything shuts down in order
     while(SDL_PollEvent(&event)) {
         if(event.type == SDL_QUIT) {
-            SDL_Quit();
-            exit(0);
+            return false;
         }
     }
+    return true;
+}
+
+Raster_Settings Screen::get_raster_settings() const {
+    Raster_Settings settings;
+    settings.light_direction = light_direction;
+    settings.backface_culling = backface_culling;
+    return settings;
+}
+
+void Screen::draw_opaque(const Model& model, bool smooth_shading, const Raster_Settings& settings) {
+    if (depth_prepass) {
+        if (smooth_shading) {
+            rasterize_model<Vertex_Lighting, After_Depth_Prepass<Gouraud_Shading>>(frame, camera, model, settings);
+        } else {
+            rasterize_model<No_Vertex_Attributes, After_Depth_Prepass<Flat_Shading>>(frame, camera, model, settings);
+        }
+    } else if (smooth_shading) {
+        rasterize_model<Vertex_Lighting, Gouraud_Shading>(frame, camera, model, settings);
+    } else {
+        rasterize_model<No_Vertex_Attributes, Flat_Shading>(frame, camera, model, settings);
+    }
 }
 
 void Screen::render_model(const Model& model) {
+    draw_opaque(model, false, get_raster_settings());
+    if (model.has_translucent_materials()) {
+        translucent_draws.push_back(Translucent_Draw{&model, false});
+    }
+}
 
-    for(const auto& face : model.get_faces()){
-        //grab vertices, and transform them so that the camera is at 0,0,0, converted to homenzgous vector 4 for matrix math
-        Vector4 vertex_0_4 = matrix_transform(camera.get_view_matrix(), to_vector4(model.get_vertices()[face.vertex_index[0]])); 
-        Vector4 vertex_1_4 = matrix_transform(camera.get_view_matrix(), to_vector4(model.get_vertices()[face.vertex_index[1]])); 
-        Vector4 vertex_2_4 = matrix_transform(camera.get_view_matrix(), to_vector4(model.get_vertices()[face.vertex_index[2]])); 
-
-        // project the coned frustrum so it is in a cube shape, this will give the appearance of objects closer to camera being bigger
-        //and objects farther away being smaller
-        vertex_0_4 = matrix_transform(camera.get_projection_matrix(), vertex_0_4);
-        vertex_1_4 = matrix_transform(camera.get_projection_matrix(), vertex_1_4);
-        vertex_2_4 = matrix_transform(camera.get_projection_matrix(), vertex_2_4);
-
-        // normalizes the cube to be a 1 by 1 by 1
-        Vector3 vertex_0 = {vertex_0_4.x / vertex_0_4.w, vertex_0_4.y / vertex_0_4.w, vertex_0_4.z / vertex_0_4.w};
-        Vector3 vertex_1 = {vertex_1_4.x / vertex_1_4.w, vertex_1_4.y / vertex_1_4.w, vertex_1_4.z / vertex_1_4.w};
-        Vector3 vertex_2 = {vertex_2_4.x / vertex_2_4.w, vertex_2_4.y / vertex_2_4.w, vertex_2_4.z / vertex_2_4.w};
-
-        //maps the 1 by 1 by cuber to the screen
-        float z_0 = dot_product(camera.get_forward(), vertex_0); 
-        float z_1 = dot_product(camera.get_forward(), vertex_1);
-        float z_2 = dot_product(camera.get_forward(), vertex_2);
-
-        vertex_0.z = z_0;
-        vertex_1.z = z_1;
-        vertex_2.z = z_2;
-
-        vertex_0 = Vector3(
-            (vertex_0.x + 1.0f) * SCREEN_WIDTH / 2,
-            (1.0f - vertex_0.y) * SCREEN_HEIGHT / 2,
-            vertex_0.z
-        );
-        vertex_1 = Vector3(
-            (vertex_1.x + 1.0f) * SCREEN_WIDTH / 2,
-            (1.0f - vertex_1.y) * SCREEN_HEIGHT / 2,
-            vertex_1.z
-        );
-        vertex_2 = Vector3(
-            (vertex_2.x + 1.0f) * SCREEN_WIDTH / 2,
-            (1.0f - vertex_2.y) * SCREEN_HEIGHT / 2,
-            vertex_2.z
-        );
-
-        //decide the color for the face
-        const Vector3& face_normal = model.get_normals()[face.normal_index[0]];
-        float brightness = dot_product(light_direction, face_normal);
-        brightness = std::max(0.0f, brightness);  
-        Color color = face.face_material.diffuse_color;
-        color.r *= brightness;
-        color.g *= brightness;
-        color.b *= brightness;
-        SDL_SetRenderDrawColor(renderer, color.r * 255, color.g * 255, color.b * 255, color.a * 255);
-
-
-        //if minimizes the check area to be on the screen and no bigger than the triangle this is for efficenacy
-        int min_x = std::max(0, std::min({static_cast<int>(vertex_0.x), static_cast<int>(vertex_1.x), static_cast<int>(vertex_2.x)}));
-        int min_y = std::max(0, std::min({static_cast<int>(vertex_0.y), static_cast<int>(vertex_1.y), static_cast<int>(vertex_2.y)}));
-        int max_x = std::min(SCREEN_WIDTH - 1, std::max({static_cast<int>(vertex_0.x), static_cast<int>(vertex_1.x), static_cast<int>(vertex_2.x)}));
-        int max_y = std::min(SCREEN_HEIGHT - 1, std::max({static_cast<int>(vertex_0.y), static_cast<int>(vertex_1.y), static_cast<int>(vertex_2.y)}));
-
-         for (int y = min_y; y <= max_y; ++y) {
-            for (int x = min_x; x <= max_x; ++x) {
-                if (is_point_inside_triangle(x, y, vertex_0, vertex_1, vertex_2)) {//check if the pixel from the area to render is in the triangle
-                    float z = barycentric_interpolation_z_value(x, y, vertex_0, vertex_1, vertex_2);//determine z depth on all points as only the vertexes have a z value
-                    if (z < z_buffer[x][y]) {//check the z_buffer if its on top render that pixel and store it
-                        z_buffer[x][y] = z;
-                        SDL_RenderDrawPointF(renderer, x, y);
-                    }
-                }
-            }
-         }
+void Screen::render_model_gourand(const Model& model) {
+    draw_opaque(model, true, get_raster_settings());
+    if (model.has_translucent_materials()) {
+        translucent_draws.push_back(Translucent_Draw{&model, true});
     }
 }
 
+void Screen::draw_translucent() {
+    //every opaque face is in by now, so the translucent ones can test against the finished depth buffer in any order
+    Raster_Settings settings = get_raster_settings();
+    for (const Translucent_Draw& draw : translucent_draws) {
+        if (draw.smooth_shading) {
+            rasterize_model<Vertex_Lighting, Translucent_Shading<Gouraud_Shading>>(frame, camera, *draw.model, settings);
+        } else {
+            rasterize_model<No_Vertex_Attributes, Translucent_Shading<Flat_Shading>>(frame, camera, *draw.model, settings);
+        }
+    }
+    translucent_draws.clear();
+    frame.resolve_translucency();
+}
 
-void Screen::render_model_gourand(const Model& model){
+void Screen::render_model_depth(const Model& model) {
+    rasterize_model<No_Vertex_Attributes, Depth_Only>(frame, camera, model, get_raster_settings());
+}
 
+void Screen::render_model_views(const Model& model, const std::vector<Raster_View>& views, bool smooth_shading) {
+    //the targets belong to the caller, clearing them is up to it
+    if (views.size() > static_cast<size_t>(MAX_RASTER_VIEWS)) {
+        std::cerr << "Only the first " << MAX_RASTER_VIEWS << " of " << views.size() << " views get rendered" << std::endl;
+    }
+    int view_count = static_cast<int>(views.size());
+    Raster_Settings settings = get_raster_settings();
+    if (smooth_shading) {
+        rasterize_model_views<Vertex_Lighting, Gouraud_Shading>(views.data(), view_count, model, settings);
+    } else {
+        rasterize_model_views<No_Vertex_Attributes, Flat_Shading>(views.data(), view_count, model, settings);
+    }
+    if (model.has_translucent_materials()) {
+        if (smooth_shading) {
+            rasterize_model_views<Vertex_Lighting, Translucent_Shading<Gouraud_Shading>>(views.data(), view_count, model, settings);
+        } else {
+            rasterize_model_views<No_Vertex_Attributes, Translucent_Shading<Flat_Shading>>(views.data(), view_count, model, settings);
+        }
+        //blended straight in like render_scene does, left accumulated the next clear would throw it away
+        for (int i = 0; i < std::min(view_count, MAX_RASTER_VIEWS); ++i) {
+            views[i].frame->resolve_translucency();
+        }
+    }
+}
+
+void Screen::render_streamed_mesh(Streamed_Mesh& mesh) {
     Matrix4 all_transforms = camera.get_projection_matrix() * camera.get_view_matrix();
-    for(const auto& face : model.get_faces()){
-        //grab vertices, and transform them so that the camera is at 0,0,0, converted to homenzgous vector 4 for matrix math
-        Vector4 vertex_0_4 = matrix_transform(all_transforms, to_vector4(model.get_vertices()[face.vertex_index[0] ])); 
-        Vector4 vertex_1_4 = matrix_transform(all_transforms, to_vector4(model.get_vertices()[face.vertex_index[1] ])); 
-        Vector4 vertex_2_4 = matrix_transform(all_transforms, to_vector4(model.get_vertices()[face.vertex_index[2] ])); 
-
-        // normalizes the cube to be a 1 by 1 by 1
-        Vector3 vertex_0 = {vertex_0_4.x / vertex_0_4.w, vertex_0_4.y / vertex_0_4.w, vertex_0_4.z / vertex_0_4.w};
-        Vector3 vertex_1 = {vertex_1_4.x / vertex_1_4.w, vertex_1_4.y / vertex_1_4.w, vertex_1_4.z / vertex_1_4.w};
-        Vector3 vertex_2 = {vertex_2_4.x / vertex_2_4.w, vertex_2_4.y / vertex_2_4.w, vertex_2_4.z / vertex_2_4.w};
-
-        //maps the 1 by 1 by cuber to the screen
-        float z_0 = dot_product(camera.get_forward(), vertex_0); 
-        float z_1 = dot_product(camera.get_forward(), vertex_1);
-        float z_2 = dot_product(camera.get_forward(), vertex_2);
-
-        vertex_0.z = z_0;
-        vertex_1.z = z_1;
-        vertex_2.z = z_2;
-
-        vertex_0 = Vector3(
-            (vertex_0.x + 1.0f) * SCREEN_WIDTH / 2,
-            (1.0f - vertex_0.y) * SCREEN_HEIGHT / 2,
-            vertex_0.z
-        );
-        vertex_1 = Vector3(
-            (vertex_1.x + 1.0f) * SCREEN_WIDTH / 2,
-            (1.0f - vertex_1.y) * SCREEN_HEIGHT / 2,
-            vertex_1.z
-        );
-        vertex_2 = Vector3(
-            (vertex_2.x + 1.0f) * SCREEN_WIDTH / 2,
-            (1.0f - vertex_2.y) * SCREEN_HEIGHT / 2,
-            vertex_2.z
-        );
-
-        Vector3 normal_0 = Vector3();
-        for (int face_index : model.get_vertex_info()[face.vertex_index[0] ]) {
-            normal_0 = normal_0 + model.get_normals()[face_index];
-        }
-        normal_0 = normal_0 / model.get_vertex_info()[face.vertex_index[0] ].size();
-        //normal_0 = normalize(normal_0);
-
-        Vector3 normal_1 = Vector3();
-        for (int face_index : model.get_vertex_info()[face.vertex_index[1] ]) {
-            normal_1 = normal_1 + model.get_normals()[face_index];
-        }
-        normal_1 = normal_1 / model.get_vertex_info()[face.vertex_index[1] ].size();
-        //normal_1 = normalize(normal_1);
-
-        Vector3 normal_2 = Vector3();
-        for (int face_index : model.get_vertex_info()[face.vertex_index[2] ]) {
-            normal_2 = normal_2 + model.get_normals()[face_index];
-        }
-        normal_2 = normal_2 / model.get_vertex_info()[face.vertex_index[2] ].size();
-        //normal_2 = normalize(normal_2);
-
-
-
-        float brightness_0 = std::min(1.0f,std::max(0.0f,dot_product(light_direction, normal_0)));
-        float brightness_1 = std::min(1.0f,std::max(0.0f,dot_product(light_direction, normal_1)));
-        float brightness_2 = std::min(1.0f,std::max(0.0f,dot_product(light_direction, normal_2)));
-
-        // Calculate color at each vertex based on brightness and diffuse color
-        Color color_0 = face.face_material.diffuse_color * brightness_0;
-        Color color_1 = face.face_material.diffuse_color * brightness_1;
-        Color color_2 = face.face_material.diffuse_color * brightness_2;
-
-        //if minimizes the check area to be on the screen and no bigger than the triangle this is for efficenacy
-        int min_x = std::max(0, std::min({static_cast<int>(vertex_0.x), static_cast<int>(vertex_1.x), static_cast<int>(vertex_2.x)}));
-        int min_y = std::max(0, std::min({static_cast<int>(vertex_0.y), static_cast<int>(vertex_1.y), static_cast<int>(vertex_2.y)}));
-        int max_x = std::min(SCREEN_WIDTH - 1, std::max({static_cast<int>(vertex_0.x), static_cast<int>(vertex_1.x), static_cast<int>(vertex_2.x)}));
-        int max_y = std::min(SCREEN_HEIGHT - 1, std::max({static_cast<int>(vertex_0.y), static_cast<int>(vertex_1.y), static_cast<int>(vertex_2.y)}));
-
-         for (int y = min_y; y <= max_y; ++y) {
-            for (int x = min_x; x <= max_x; ++x) {
-                if (is_point_inside_triangle(x, y, vertex_0, vertex_1, vertex_2)) {//check if the pixel from the area to render is in the triangle
-                    float z = barycentric_interpolation_z_value(x, y, vertex_0, vertex_1, vertex_2);
-                    if (z < z_buffer[x][y]) {//check the z_buffer if its on top render that pixel and store it
-                        z_buffer[x][y] = z;
-
-                        Vector3 weights = barycentric_interpolation_weights(x, y, vertex_0, vertex_1, vertex_2);
-                        Color interpolated_color = color_0 * weights.z + color_1 * weights.x + color_2 * weights.y;
-
-                        SDL_SetRenderDrawColor(renderer, interpolated_color.r * 255, interpolated_color.g * 255, interpolated_color.b * 255, interpolated_color.a*255);
-                        SDL_RenderDrawPoint(renderer, x, y);
-                    }
-                }
+    //only chunks in view are mapped in, the rest of the mesh never leaves the disk
+    for (int chunk_index : mesh.update_residency(camera)) {
+        const Chunk_Info& chunk = mesh.get_chunks()[chunk_index];
+        if (!occlusion_culler.is_visible(chunk.bounds_min, chunk.bounds_max)) {
+            continue;
+        }
+        const Chunk_Triangle* triangles = mesh.get_triangles(chunk_index);
+        for (size_t i = 0; i < mesh.get_triangle_count(chunk_index); ++i) {
+            const Chunk_Triangle& triangle = triangles[i];
+            float brightness = std::max(0.0f, dot_product(light_direction, triangle.normal));
+            Color color = triangle.color;
+            color.r *= brightness;
+            color.g *= brightness;
+            color.b *= brightness;
+            rasterize_triangle<Flat_Shading>(
+                frame,
+                project_to_screen(triangle.vertices[0], all_transforms, frame.width, frame.height),
+                project_to_screen(triangle.vertices[1], all_transforms, frame.width, frame.height),
+                project_to_screen(triangle.vertices[2], all_transforms, frame.width, frame.height),
+                Flat_Shading::Face_State{pack_color(color), color}
+            );
+        }
+    }
+}
+
+void Screen::render_models(const std::vector<Model*>& models, bool smooth_shading) {
+    //occluders first, the flagged ones, or failing that whichever models look biggest from here
+    Arena_Vector<Model*> occluders{Arena_Allocator<Model*>(frame_arena)};
+    occluders.reserve(models.size());
+    for (Model* model : models) {
+        if (model->is_occluder()) {
+            occluders.push_back(model);
+        }
+    }
+    if (occluders.empty()) {
+        auto screen_size = [&](const Model* model) {
+            //radius over distance squared, roughly how much of the screen the bounds cover
+            Vector3 bounds_min, bounds_max;
+            model->get_bounds(bounds_min, bounds_max);
+            Vector3 half_extent = (bounds_max - bounds_min) * 0.5f;
+            Vector3 to_center = bounds_min + half_extent - camera.get_position();
+            return dot_product(half_extent, half_extent) / std::max(dot_product(to_center, to_center), 1e-6f);
+        };
+        occluders.assign(models.begin(), models.end());
+        int count = std::min(automatic_occluder_count, static_cast<int>(occluders.size()));
+        std::partial_sort(occluders.begin(), occluders.begin() + count, occluders.end(), [&](const Model* a, const Model* b) {
+            return screen_size(a) > screen_size(b);
+        });
+        occluders.resize(count);
+    }
+    for (const Model* occluder : occluders) {
+        occlusion_culler.add_occluder(*occluder);
+    }
+
+    for (Model* model : models) {
+        if (std::find(occluders.begin(), occluders.end(), model) == occluders.end()) {
+            Vector3 bounds_min, bounds_max;
+            model->get_bounds(bounds_min, bounds_max);
+            if (!occlusion_culler.is_visible(bounds_min, bounds_max)) {
+                continue;
+            }
+        }
+        if (smooth_shading) {
+            render_model_gourand(*model);
+        } else {
+            render_model(*model);
+        }
+    }
+}
+
+void Screen::render_scene(const std::vector<Model*>& models, bool smooth_shading) {
+    Raster_Settings settings = get_raster_settings();
+    //shading changes touch every pixel, the revisions cannot see those
+    bool settings_changed = smooth_shading != retained_smooth_shading || settings.backface_culling != retained_settings.backface_culling
+        || settings.light_direction.x != retained_settings.light_direction.x || settings.light_direction.y != retained_settings.light_direction.y
+        || settings.light_direction.z != retained_settings.light_direction.z;
+    if (!retained_frame || settings_changed) {
+        dirty_regions.invalidate();
+    }
+    retained_frame = true;
+    retained_smooth_shading = smooth_shading;
+    retained_settings = settings;
+    frame_arena.reset();
+    translucent_draws.clear();
+
+    const std::vector<Pixel_Rect>& dirty_rects = dirty_regions.update(camera, frame.width, frame.height, models);
+    upload_rect = Pixel_Rect();
+    if (dirty_rects.empty()) {
+        return;  //the frame buffer already holds exactly this
+    }
+    for (const Pixel_Rect& rect : dirty_rects) {
+        upload_rect = upload_rect.is_empty() ? rect : Pixel_Rect{
+            std::min(upload_rect.min_x, rect.min_x), std::min(upload_rect.min_y, rect.min_y),
+            std::max(upload_rect.max_x, rect.max_x), std::max(upload_rect.max_y, rect.max_y)
+        };
+    }
+
+    for (const Pixel_Rect& rect : dirty_rects) {
+        frame.clear_rect(pack_color(BACKGROUND_COLOR), rect);
+    }
+    //each model is drawn once, clipped to exactly the dirty rects it overlaps, so it gets transformed once however many
+    //rects it reaches and never writes the clean pixels between them
+    auto clip_to_model = [&](size_t model_index) {
+        model_rects.clear();
+        for (const Pixel_Rect& rect : dirty_rects) {
+            if (dirty_regions.get_screen_rect(model_index).intersects(rect)) {
+                model_rects.push_back(rect);
+            }
+        }
+        frame.set_scissor_rects(model_rects);
+        return !model_rects.empty();
+    };
+    if (depth_prepass) {
+        for (size_t i = 0; i < models.size(); ++i) {
+            if (clip_to_model(i)) {
+                rasterize_model<No_Vertex_Attributes, Depth_Only>(frame, camera, *models[i], settings);
             }
-         }
+        }
+    }
+    bool has_translucency = false;
+    for (size_t i = 0; i < models.size(); ++i) {
+        if (clip_to_model(i)) {
+            draw_opaque(*models[i], smooth_shading, settings);
+            has_translucency = has_translucency || models[i]->has_translucent_materials();
+        }
     }
-}
\ No newline at end of file
+    //translucency last, and resolved right away since present has nothing queued to draw for this path.
+    //only the dirty rects get reset and blended, the rest of the frame already holds its resolved colors
+    if (has_translucency) {
+        frame.begin_translucency_rects(dirty_rects);
+        for (size_t i = 0; i < models.size(); ++i) {
+            if (!models[i]->has_translucent_materials() || !clip_to_model(i)) {
+                continue;
+            }
+            if (smooth_shading) {
+                rasterize_model<Vertex_Lighting, Translucent_Shading<Gouraud_Shading>>(frame, camera, *models[i], settings);
+            } else {
+                rasterize_model<No_Vertex_Attributes, Translucent_Shading<Flat_Shading>>(frame, camera, *models[i], settings);
+            }
+        }
+        frame.resolve_translucency();
+    }
+    frame.reset_scissor();
+}
+
+void Screen::render_model_ray_traced(const Model& model, const BVH& bvh) {
+    Ray_Tracer ray_tracer(model, bvh, light_direction, BACKGROUND_COLOR);
+    ray_tracer.render(frame, camera, workers);
+}
+
+bool Screen::pick(int window_x, int window_y, const BVH& bvh, Ray_Hit& hit) const {
+    //window coordinates, so this works the same whatever the current render resolution is
+    float ndc_x = (window_x + 0.5f) * 2.0f / SCREEN_WIDTH - 1.0f;
+    float ndc_y = 1.0f - (window_y + 0.5f) * 2.0f / SCREEN_HEIGHT;
+    return bvh.intersect(camera.get_ray(ndc_x, ndc_y), hit);
+}
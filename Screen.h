@@ -9,26 +9,87 @@
 #include "Model.h"
 #include "Utilities.h"
 #include "Camera.h"
+#include "Frame_Buffer.h"
+#include "BVH.h"
+#include "Thread_Pool.h"
+#include "Streamed_Mesh.h"
+#include "Occlusion_Culler.h"
+#include "Frame_Capture.h"
+#include "Arena.h"
+#include "Rasterizer.h"
+#include "Dirty_Regions.h"
 
 class Screen {
 private:
     SDL_Event event;
     SDL_Window* window;
-    std::vector<SDL_FPoint> points;
-    float z_buffer[SCREEN_WIDTH][SCREEN_HEIGHT];
+    SDL_Texture* render_texture; //streaming texture at the render resolution, stretched over the window on present
+    int texture_width;
+    int texture_height;
+    Thread_Pool workers;
+
+    //models with translucent faces, their opaque faces are already drawn and the rest waits for present
+    struct Translucent_Draw {
+        const Model* model;
+        bool smooth_shading;
+    };
+    std::vector<Translucent_Draw> translucent_draws;
+
+    //render_scene keeps the frame between frames and only redraws what changed
+    Dirty_Regions dirty_regions;
+    bool retained_frame = false;       //the frame buffer still holds the last render_scene image
+    bool retained_smooth_shading = true;
+    Raster_Settings retained_settings;
+    Pixel_Rect upload_rect;            //part of the frame the next present has to send to the texture
+    //a retained frame cannot be handed to the capture, this second buffer goes instead. it comes back from the capture
+    //holding an older frame, so only the tiles redrawn since then have to be copied in
+    std::vector<uint32_t> capture_buffer;
+    uint64_t capture_buffer_revision = 0; //Dirty_Regions frame revision the capture buffer holds, 0 for nothing
+    std::vector<Pixel_Rect> capture_rects;
+    std::vector<Pixel_Rect> model_rects;  //render_scene scratch, the dirty rects the current model overlaps
+    Occlusion_Culler occlusion_culler;
+
+    Raster_Settings get_raster_settings() const;
+    void draw_opaque(const Model& model, bool smooth_shading, const Raster_Settings& settings);
+    void draw_translucent();
 
 public:
     Camera camera;
     Vector3 light_direction;
+    bool backface_culling = true; //skip meshlets facing fully away, only safe for closed meshes
+    //shade only what ends up visible: render_scene lays down every model's depth first, render_model and
+    //render_model_gourand then expect render_model_depth to have been called for everything in the frame already
+    bool depth_prepass = false;
+    int automatic_occluder_count = 2; //biggest on screen models used as occluders when none are flagged
     SDL_Renderer* renderer;
+    Frame_Buffer frame;
+    Arena frame_arena; //scratch memory for anything that only lives until the next clear_display
     Screen();
     ~Screen();
     
+    void set_render_resolution(int width, int height);
     void clear_display();
-    void input();
+    void present();  //draws the queued translucent faces, then shows the frame
+    void capture(Frame_Capture& frame_capture);
+    bool input();
 
     void render_model(const Model& model);
     void render_model_gourand(const Model& model);
+    void render_model_depth(const Model& model); //depth buffer only, the pre-pass for depth_prepass
+    //one pass over the model for several cameras (stereo, cube map faces, split screen), each view fills its own frame buffer.
+    //translucent faces go in and get resolved right away, so draw translucent models last
+    void render_model_views(const Model& model, const std::vector<Raster_View>& views, bool smooth_shading = true);
+    void render_model_ray_traced(const Model& model, const BVH& bvh);
+    void render_models(const std::vector<Model*>& models, bool smooth_shading = true);
+    //the whole frame in one call, used instead of clear_display plus render calls. the last frame is kept and only the
+    //tiles under models that changed get cleared and drawn again, an idle scene costs next to nothing.
+    //no occlusion culling here, the redrawn areas are small enough that it would not pay for itself
+    void render_scene(const std::vector<Model*>& models, bool smooth_shading = true);
+    void render_streamed_mesh(Streamed_Mesh& mesh);
+
+    bool pick(int window_x, int window_y, const BVH& bvh, Ray_Hit& hit) const;
+    //stats cover the frame since the last clear_display, read them before the next one
+    const Occlusion_Culler& get_occlusion_culler() const { return occlusion_culler; }
 };
 
 #endif // SCREEN_H
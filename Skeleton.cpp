@@ -0,0 +1,78 @@
+#include "Skeleton.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+int Skeleton::add_joint(const std::string& name, int parent, const Vector3& translation, const Quaternion& rotation, const Vector3& scale) {
+    if (parent >= static_cast<int>(joints.size())) {
+        std::cerr << "Joint " << name << " added before its parent, treating it as a root" << std::endl;
+        parent = -1;
+    }
+    Joint joint;
+    joint.name = name;
+    joint.parent = parent;
+    joint.rest_translation = translation;
+    joint.rest_rotation = rotation;
+    joint.rest_scale = scale;
+
+    Matrix4 local = compose_transform(translation, rotation, scale);
+    Matrix4 bind = parent >= 0 ? bind_transforms[parent] * local : local;
+    joint.inverse_bind_transform = affine_inverse(bind);
+
+    bind_transforms.push_back(bind);
+    joints.push_back(joint);
+    return static_cast<int>(joints.size()) - 1;
+}
+
+int Skeleton::find_joint(const std::string& name) const {
+    for (size_t i = 0; i < joints.size(); ++i) {
+        if (joints[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void Skeleton::evaluate_rest_pose(Skeleton_Pose& pose) const {
+    Animation_Clip empty_clip;
+    evaluate(empty_clip, 0.0f, pose);
+}
+
+void Skeleton::evaluate(const Animation_Clip& clip, float time, Skeleton_Pose& pose) const {
+    size_t joint_count = joints.size();
+    pose.global_transforms.resize(joint_count);
+    pose.skin_matrices.resize(joint_count);
+
+    //local transforms go into the global slots first, everything starts at rest
+    for (size_t i = 0; i < joint_count; ++i) {
+        pose.global_transforms[i] = compose_transform(joints[i].rest_translation, joints[i].rest_rotation, joints[i].rest_scale);
+    }
+
+    if (clip.duration > 0.0f) {
+        time = clip.looping ? time - clip.duration * std::floor(time / clip.duration) : std::min(std::max(time, 0.0f), clip.duration);
+    }
+    for (const auto& channel : clip.channels) {
+        if (channel.joint < 0 || channel.joint >= static_cast<int>(joint_count) || channel.keyframes.empty()) {
+            continue;
+        }
+        //first key after the time, the pose sits between it and the one before
+        const std::vector<Joint_Keyframe>& keys = channel.keyframes;
+        auto next = std::upper_bound(keys.begin(), keys.end(), time, [](float t, const Joint_Keyframe& key) { return t < key.time; });
+        const Joint_Keyframe& after = next == keys.end() ? keys.back() : *next;
+        const Joint_Keyframe& before = next == keys.begin() ? keys.front() : *(next - 1);
+        float span = after.time - before.time;
+        float t = span > 0.0f ? (time - before.time) / span : 0.0f;
+
+        Vector3 translation = before.translation + (after.translation - before.translation) * t;
+        Vector3 scale = before.scale + (after.scale - before.scale) * t;
+        pose.global_transforms[channel.joint] = compose_transform(translation, slerp(before.rotation, after.rotation, t), scale);
+    }
+
+    //parents come first, so their global transform is already final by the time a child needs it
+    for (size_t i = 0; i < joint_count; ++i) {
+        if (joints[i].parent >= 0) {
+            pose.global_transforms[i] = pose.global_transforms[joints[i].parent] * pose.global_transforms[i];
+        }
+        pose.skin_matrices[i] = pose.global_transforms[i] * joints[i].inverse_bind_transform;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+File Description:
+- A joint hierarchy plus keyframed animation clips for it. Evaluating a clip
+- at some time gives one skin matrix per joint (current pose times inverse
+- bind pose), which is what Skinned_Model blends the vertices with.
+- Joints are stored parents first, so a single pass in order can build every
+- global transform from its parent's.
+Important References:
+- https://en.wikipedia.org/wiki/Slerp
+*/
+
+#ifndef SKELETON_H
+#define SKELETON_H
+//Standard C Libraries
+#include <vector>  //joints, keyframes
+#include <string>  //joint and clip names
+//Created Files
+#include "Utilities.h"
+
+struct Joint {
+    std::string name;
+    int parent;                       //-1 for a root, always lower than this joint's own index
+    Vector3 rest_translation;         //bind pose, relative to the parent
+    Quaternion rest_rotation;
+    Vector3 rest_scale;
+    Matrix4 inverse_bind_transform;   //model space back into the joint's space at bind time
+};
+
+struct Joint_Keyframe {
+    float time;  //seconds
+    Vector3 translation;
+    Quaternion rotation;
+    Vector3 scale;
+};
+
+//keys for one joint, sorted by time, joints without a channel hold their rest pose
+struct Animation_Channel {
+    int joint;
+    std::vector<Joint_Keyframe> keyframes;
+};
+
+struct Animation_Clip {
+    std::string name;
+    float duration = 0.0f;
+    bool looping = true;
+    std::vector<Animation_Channel> channels;
+};
+
+//evaluated transforms for every joint, kept between frames so posing does not allocate
+struct Skeleton_Pose {
+    std::vector<Matrix4> global_transforms;
+    std::vector<Matrix4> skin_matrices;
+};
+
+class Skeleton {
+    private:
+        std::vector<Joint> joints;
+        std::vector<Matrix4> bind_transforms;  //global rest transforms, only needed while adding children
+
+    public:
+        //the parent has to be added first, returns the new joint's index
+        int add_joint(const std::string& name, int parent, const Vector3& translation, const Quaternion& rotation, const Vector3& scale = Vector3(1, 1, 1));
+        int find_joint(const std::string& name) const;
+
+        void evaluate(const Animation_Clip& clip, float time, Skeleton_Pose& pose) const;
+        void evaluate_rest_pose(Skeleton_Pose& pose) const;
+
+        const std::vector<Joint>& get_joints() const { return joints; }
+        int get_joint_count() const { return static_cast<int>(joints.size()); }
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "Skinned_Model.h"
+#include <iostream>
+#include <cmath>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+    const int SKINNING_BATCH_SIZE = 4096; //vertices per parallel_for index, big enough to keep scheduling cost out of the picture
+
+    Skin_Matrix to_skin_matrix(const Matrix4& mat) {
+        Skin_Matrix skin;
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 3; ++row) {
+                skin.columns[column][row] = mat.matrix[row][column];
+            }
+            skin.columns[column][3] = 0.0f;
+        }
+        return skin;
+    }
+
+#if defined(__SSE__)
+    //weighted sum of the joint matrices, four floats at a time, then one transform with the result
+    inline Vector3 skin_vector(const Skin_Matrix* matrices, const Vertex_Joints& joints, const Vector3& value, bool is_point) {
+        __m128 column_0 = _mm_setzero_ps();
+        __m128 column_1 = _mm_setzero_ps();
+        __m128 column_2 = _mm_setzero_ps();
+        __m128 column_3 = _mm_setzero_ps();
+        for (int i = 0; i < MAX_JOINT_INFLUENCES; ++i) {
+            const Skin_Matrix& matrix = matrices[joints.joints[i]];
+            __m128 weight = _mm_set1_ps(joints.weights[i]);
+            column_0 = _mm_add_ps(column_0, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[0])));
+            column_1 = _mm_add_ps(column_1, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[1])));
+            column_2 = _mm_add_ps(column_2, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[2])));
+            column_3 = _mm_add_ps(column_3, _mm_mul_ps(weight, _mm_load_ps(matrix.columns[3])));
+        }
+        __m128 result = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(column_0, _mm_set1_ps(value.x)), _mm_mul_ps(column_1, _mm_set1_ps(value.y))),
+            _mm_mul_ps(column_2, _mm_set1_ps(value.z))
+        );
+        if (is_point) {
+            result = _mm_add_ps(result, column_3);
+        }
+        alignas(16) float out[4];
+        _mm_store_ps(out, result);
+        return Vector3(out[0], out[1], out[2]);
+    }
+#else
+    inline Vector3 skin_vector(const Skin_Matrix* matrices, const Vertex_Joints& joints, const Vector3& value, bool is_point) {
+        float blended[4][3] = {};
+        for (int i = 0; i < MAX_JOINT_INFLUENCES; ++i) {
+            const Skin_Matrix& matrix = matrices[joints.joints[i]];
+            float weight = joints.weights[i];
+            for (int column = 0; column < 4; ++column) {
+                for (int row = 0; row < 3; ++row) {
+                    blended[column][row] += weight * matrix.columns[column][row];
+                }
+            }
+        }
+        float w = is_point ? 1.0f : 0.0f;
+        return Vector3(
+            blended[0][0] * value.x + blended[1][0] * value.y + blended[2][0] * value.z + blended[3][0] * w,
+            blended[0][1] * value.x + blended[1][1] * value.y + blended[2][1] * value.z + blended[3][1] * w,
+            blended[0][2] * value.x + blended[1][2] * value.y + blended[2][2] * value.z + blended[3][2] * w
+        );
+    }
+#endif
+}
+
+Skinned_Model::Skinned_Model() : model(nullptr), joint_count(0) {}
+
+bool Skinned_Model::bind(Model& target, const std::vector<Vertex_Joints>& joints, int skeleton_joint_count) {
+    if (!target.has_vertex_streams()) {
+        std::cerr << "Cannot skin a model whose vertex streams were released" << std::endl;
+        return false;
+    }
+    if (joints.size() != target.get_vertices().size() || skeleton_joint_count <= 0) {
+        std::cerr << "Skin weights do not match the model: " << joints.size() << " for " << target.get_vertices().size() << " vertices" << std::endl;
+        return false;
+    }
+    model = &target;
+    joint_count = skeleton_joint_count;
+    bind_positions = target.get_vertices();
+    bind_normals = target.get_normals();
+    morph_targets.clear();
+    morph_weights.clear();
+
+    //weights get normalized here so the blend never has to, bad joint indices fall back to the root
+    vertex_joints = joints;
+    for (auto& vertex : vertex_joints) {
+        float total = 0.0f;
+        for (int i = 0; i < MAX_JOINT_INFLUENCES; ++i) {
+            if (vertex.joints[i] >= joint_count) {
+                vertex.joints[i] = 0;
+                vertex.weights[i] = 0.0f;
+            }
+            total += vertex.weights[i];
+        }
+        if (total <= 0.0f) {
+            vertex.joints[0] = 0;
+            vertex.weights[0] = 1.0f;
+            total = 1.0f;
+        }
+        for (int i = 0; i < MAX_JOINT_INFLUENCES; ++i) {
+            vertex.weights[i] /= total;
+        }
+    }
+
+    //normals are indexed apart from vertices in an OBJ, borrow the joints of any vertex that uses each one
+    normal_vertices.assign(bind_normals.size(), -1);
+    for (const auto& face : target.get_faces()) {
+        for (int corner = 0; corner < 3; ++corner) {
+            int normal_index = face.normal_index[corner];
+            if (normal_index >= 0 && normal_index < static_cast<int>(normal_vertices.size()) && normal_vertices[normal_index] == -1) {
+                normal_vertices[normal_index] = face.vertex_index[corner];
+            }
+        }
+    }
+    return true;
+}
+
+int Skinned_Model::add_morph_target(const Morph_Target& target) {
+    if (target.position_deltas.size() != bind_positions.size() ||
+        (!target.normal_deltas.empty() && target.normal_deltas.size() != bind_normals.size())) {
+        std::cerr << "Morph target " << target.name << " does not match the bound model" << std::endl;
+        return -1;
+    }
+    morph_targets.push_back(target);
+    morph_weights.push_back(0.0f);
+    return static_cast<int>(morph_targets.size()) - 1;
+}
+
+void Skinned_Model::set_morph_weight(int target_index, float weight) {
+    if (target_index >= 0 && target_index < static_cast<int>(morph_weights.size())) {
+        morph_weights[target_index] = weight;
+    }
+}
+
+void Skinned_Model::deform_vertices(std::vector<Vector3>& positions, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        Vector3 position = bind_positions[i];
+        for (int target : active_morph_targets) {
+            position = position + morph_targets[target].position_deltas[i] * morph_weights[target];
+        }
+        positions[i] = skin_vector(skin_matrices.data(), vertex_joints[i], position, true);
+    }
+}
+
+void Skinned_Model::deform_normals(std::vector<Vector3>& normals, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        Vector3 normal = bind_normals[i];
+        for (int target : active_morph_targets) {
+            if (!morph_targets[target].normal_deltas.empty()) {
+                normal = normal + morph_targets[target].normal_deltas[i] * morph_weights[target];
+            }
+        }
+        if (normal_vertices[i] >= 0) {
+            //only right for rotation and uniform scale, non uniform scale would need the inverse transpose
+            normal = skin_vector(skin_matrices.data(), vertex_joints[normal_vertices[i]], normal, false);
+        }
+        float length = std::sqrt(dot_product(normal, normal));
+        normals[i] = length > 0.0f ? normal / length : normal;
+    }
+}
+
+void Skinned_Model::update(const Skeleton_Pose& pose, Thread_Pool& workers) {
+    if (!model) {
+        return;
+    }
+    if (static_cast<int>(pose.skin_matrices.size()) < joint_count) {
+        std::cerr << "Pose has " << pose.skin_matrices.size() << " joints, the skin needs " << joint_count << std::endl;
+        return;
+    }
+    skin_matrices.resize(pose.skin_matrices.size());
+    for (size_t i = 0; i < pose.skin_matrices.size(); ++i) {
+        skin_matrices[i] = to_skin_matrix(pose.skin_matrices[i]);
+    }
+    active_morph_targets.clear();
+    for (size_t i = 0; i < morph_weights.size(); ++i) {
+        if (morph_weights[i] != 0.0f) {
+            active_morph_targets.push_back(static_cast<int>(i));
+        }
+    }
+
+    //vertex batches first then normal batches, all in one parallel_for so the workers never sit between the two
+    int vertex_count = static_cast<int>(bind_positions.size());
+    int normal_count = static_cast<int>(bind_normals.size());
+    int vertex_batches = (vertex_count + SKINNING_BATCH_SIZE - 1) / SKINNING_BATCH_SIZE;
+    int normal_batches = (normal_count + SKINNING_BATCH_SIZE - 1) / SKINNING_BATCH_SIZE;
+    //fetched here, the mutable accessors bump the model's revision and that must not happen from every worker at once
+    std::vector<Vector3>& positions = model->get_mutable_vertices();
+    std::vector<Vector3>& normals = model->get_mutable_normals();
+    workers.parallel_for(vertex_batches + normal_batches, [this, vertex_batches, &positions, &normals](int batch) {
+        if (batch < vertex_batches) {
+            int begin = batch * SKINNING_BATCH_SIZE;
+            deform_vertices(positions, begin, std::min(begin + SKINNING_BATCH_SIZE, get_vertex_count()));
+        } else {
+            int begin = (batch - vertex_batches) * SKINNING_BATCH_SIZE;
+            deform_normals(normals, begin, std::min(begin + SKINNING_BATCH_SIZE, static_cast<int>(bind_normals.size())));
+        }
+    });
+
+    //the mesh changed shape, so the meshlet spheres and cones have to be rebuilt
+    model->update_meshlet_bounds();
+}
@@ -0,0 +1,80 @@
+/*
+File Description:
+- Deforms a Model every frame from its bind pose: morph target deltas first,
+- then linear blend skinning with up to four joints per vertex. The results
+- are written straight into the model's vertices and normals, so everything
+- that draws a Model draws the animated pose without knowing about it.
+- Skinning runs in batches on a Thread_Pool and uses SSE when it is available,
+- blending four joint matrices into one and transforming with that.
+- Rigid transforms on the model (rotate, translate...) get overwritten by the
+- next update, move the skeleton's root instead.
+Important References:
+- https://en.wikipedia.org/wiki/Skeletal_animation
+- https://en.wikipedia.org/wiki/Morph_target_animation
+*/
+
+#ifndef SKINNED_MODEL_H
+#define SKINNED_MODEL_H
+//Standard C Libraries
+#include <vector>   //per vertex data
+#include <string>   //morph target names
+#include <cstdint>  //joint indices
+//Created Files
+#include "Model.h"
+#include "Skeleton.h"
+#include "Thread_Pool.h"
+
+const int MAX_JOINT_INFLUENCES = 4;
+
+//which joints move a vertex and by how much, unused slots have a weight of 0
+struct Vertex_Joints {
+    uint16_t joints[MAX_JOINT_INFLUENCES];
+    float weights[MAX_JOINT_INFLUENCES];
+};
+
+//offsets from the bind pose, one per vertex (and optionally one per normal) of the model
+struct Morph_Target {
+    std::string name;
+    std::vector<Vector3> position_deltas;
+    std::vector<Vector3> normal_deltas; //can be left empty
+};
+
+//a skin matrix laid out as four columns so SSE can scale and add whole columns, the last row is implied
+struct alignas(16) Skin_Matrix {
+    float columns[4][4];
+};
+
+class Skinned_Model {
+    private:
+        Model* model;
+        std::vector<Vector3> bind_positions;
+        std::vector<Vector3> bind_normals;
+        std::vector<Vertex_Joints> vertex_joints;
+        std::vector<int> normal_vertices;  //a vertex using each normal, normals are skinned with its joints
+
+        std::vector<Morph_Target> morph_targets;
+        std::vector<float> morph_weights;
+        std::vector<int> active_morph_targets;  //nonzero weights only, rebuilt every update
+
+        std::vector<Skin_Matrix> skin_matrices;
+        int joint_count;
+
+        void deform_vertices(std::vector<Vector3>& positions, int begin, int end);
+        void deform_normals(std::vector<Vector3>& normals, int begin, int end);
+
+    public:
+        Skinned_Model();
+
+        //takes the model's current vertices and normals as the bind pose, joints has one entry per vertex
+        bool bind(Model& target, const std::vector<Vertex_Joints>& joints, int skeleton_joint_count);
+        int add_morph_target(const Morph_Target& target);  //returns its index, or -1 if the sizes do not match the model
+        void set_morph_weight(int target_index, float weight);
+
+        //poses the model, pose has to come from the skeleton the weights were made for
+        void update(const Skeleton_Pose& pose, Thread_Pool& workers);
+
+        int get_vertex_count() const { return static_cast<int>(bind_positions.size()); }
+        const std::vector<Morph_Target>& get_morph_targets() const { return morph_targets; }
+};
+
+#endif
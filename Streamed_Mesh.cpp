@@ -0,0 +1,147 @@
+#include "Streamed_Mesh.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+Streamed_Mesh::Streamed_Mesh() : file_descriptor(-1), memory_budget(0), resident_bytes(0), frame_index(0) {}
+
+Streamed_Mesh::~Streamed_Mesh() {
+    close();
+}
+
+bool Streamed_Mesh::open(const std::string& chunk_file_path, size_t memory_budget_bytes) {
+    close();
+    file_descriptor = ::open(chunk_file_path.c_str(), O_RDONLY);
+    if (file_descriptor == -1) {
+        std::cerr << "Failed to open chunk file: " << chunk_file_path << std::endl;
+        return false;
+    }
+
+    //only the header and chunk table are read up front, triangles stay on disk until a chunk is seen
+    Chunk_File_Header header;
+    if (pread(file_descriptor, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+        || std::memcmp(header.magic, CHUNK_FILE_MAGIC, sizeof(CHUNK_FILE_MAGIC)) != 0) {
+        std::cerr << "Not a chunk file: " << chunk_file_path << std::endl;
+        close();
+        return false;
+    }
+    chunks.resize(header.chunk_count);
+    ssize_t table_size = sizeof(Chunk_Info) * header.chunk_count;
+    if (pread(file_descriptor, chunks.data(), table_size, sizeof(header)) != table_size) {
+        std::cerr << "Truncated chunk table: " << chunk_file_path << std::endl;
+        close();
+        return false;
+    }
+
+    residency.assign(chunks.size(), Resident_Chunk());
+    visible_chunks.reserve(chunks.size());
+    memory_budget = memory_budget_bytes;
+    return true;
+}
+
+void Streamed_Mesh::close() {
+    for (int i = 0; i < static_cast<int>(residency.size()); ++i) {
+        if (residency[i].mapping) {
+            page_out(i);
+        }
+    }
+    if (file_descriptor != -1) {
+        ::close(file_descriptor);
+        file_descriptor = -1;
+    }
+    chunks.clear();
+    residency.clear();
+    lru_order.clear();
+    visible_chunks.clear();
+    resident_bytes = 0;
+}
+
+size_t Streamed_Mesh::chunk_bytes(int chunk_index) const {
+    return chunks[chunk_index].triangle_count * sizeof(Chunk_Triangle);
+}
+
+bool Streamed_Mesh::page_in(int chunk_index) {
+    //mmap offsets have to be page aligned, chunks are not, so map from the page the chunk starts in
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    const Chunk_Info& chunk = chunks[chunk_index];
+    size_t aligned_offset = chunk.offset - chunk.offset % page_size;
+    size_t leading_bytes = chunk.offset - aligned_offset;
+    size_t mapping_size = leading_bytes + chunk_bytes(chunk_index);
+
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, file_descriptor, aligned_offset);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map chunk " << chunk_index << std::endl;
+        return false;
+    }
+    //the whole chunk is about to be walked front to back, start reading it now rather than fault page by page
+    madvise(mapping, mapping_size, MADV_WILLNEED);
+
+    Resident_Chunk& resident = residency[chunk_index];
+    resident.mapping = mapping;
+    resident.mapping_size = mapping_size;
+    resident.triangles = reinterpret_cast<const Chunk_Triangle*>(static_cast<const char*>(mapping) + leading_bytes);
+    lru_order.push_front(chunk_index);
+    resident.lru_position = lru_order.begin();
+    resident_bytes += chunk_bytes(chunk_index);
+    return true;
+}
+
+void Streamed_Mesh::page_out(int chunk_index) {
+    Resident_Chunk& resident = residency[chunk_index];
+    munmap(resident.mapping, resident.mapping_size);
+    lru_order.erase(resident.lru_position);
+    resident_bytes -= chunk_bytes(chunk_index);
+    resident = Resident_Chunk();
+}
+
+void Streamed_Mesh::set_memory_budget(size_t memory_budget_bytes) {
+    memory_budget = memory_budget_bytes;
+    while (resident_bytes > memory_budget && !lru_order.empty()) {
+        page_out(lru_order.back());
+    }
+}
+
+const std::vector<int>& Streamed_Mesh::update_residency(const Camera& camera) {
+    frame_index++;
+    visible_chunks.clear();
+    Frustum frustum = camera.get_viewing_volume();
+    for (int i = 0; i < static_cast<int>(chunks.size()); ++i) {
+        if (chunks[i].triangle_count > 0 && frustum.intersects_box(chunks[i].bounds_min, chunks[i].bounds_max)) {
+            visible_chunks.push_back(i);
+        }
+    }
+
+    //nearest chunks get the budget first, if it runs out it is the far away detail that goes missing
+    const Vector3& camera_position = camera.get_position();
+    auto distance_squared = [&](int chunk_index) {
+        Vector3 offset = (chunks[chunk_index].bounds_min + chunks[chunk_index].bounds_max) * 0.5f - camera_position;
+        return dot_product(offset, offset);
+    };
+    std::sort(visible_chunks.begin(), visible_chunks.end(), [&](int a, int b) {
+        return distance_squared(a) < distance_squared(b);
+    });
+
+    size_t drawable_count = 0;
+    for (int chunk_index : visible_chunks) {
+        Resident_Chunk& resident = residency[chunk_index];
+        if (resident.mapping) {
+            lru_order.splice(lru_order.begin(), lru_order, resident.lru_position);
+        } else {
+            //make room by dropping whatever was drawn longest ago, but never a chunk already claimed this frame
+            while (resident_bytes + chunk_bytes(chunk_index) > memory_budget && !lru_order.empty()
+                   && residency[lru_order.back()].last_used_frame != frame_index) {
+                page_out(lru_order.back());
+            }
+            if (resident_bytes + chunk_bytes(chunk_index) > memory_budget || !page_in(chunk_index)) {
+                break;  //over the ceiling, everything further away than this waits for a later frame
+            }
+        }
+        resident.last_used_frame = frame_index;
+        visible_chunks[drawable_count++] = chunk_index;
+    }
+    visible_chunks.resize(drawable_count);
+    return visible_chunks;
+}
@@ -0,0 +1,93 @@
+/*
+File Description:
+- Out of core rendering for meshes too large to load with Loader::load_obj.
+- Loader::build_chunk_file splits a huge OBJ into spatially coherent chunks
+- on disk, each with its own bounds. At render time only chunks inside the
+- camera frustum get memory mapped in, and an LRU list pages the least
+- recently drawn ones back out whenever the mapped total passes the budget.
+
+Library Resources:
+- mmap / munmap / madvise (POSIX)
+*/
+
+#ifndef STREAMED_MESH_H
+#define STREAMED_MESH_H
+//Standard C Libraries
+#include <vector>   //chunk tables
+#include <list>     //lru order
+#include <string>   //file paths
+#include <cstdint>  //on disk sizes
+#include <cstddef>  //size_t
+//Created Files
+#include "Utilities.h"
+#include "Camera.h"
+
+//------------------------------------On_Disk_Layout------------------------------
+//[Chunk_File_Header][Chunk_Info x chunk_count][Chunk_Triangle data for every chunk]
+const char CHUNK_FILE_MAGIC[8] = {'D', 'I', 'M', 'C', 'H', 'N', 'K', '1'};
+
+struct Chunk_File_Header {
+    char magic[8];
+    uint32_t chunk_count;
+    uint32_t padding;
+};
+
+struct Chunk_Info {
+    Vector3 bounds_min;
+    Vector3 bounds_max;
+    uint64_t offset;          //byte offset of the first triangle from the start of the file
+    uint64_t triangle_count;
+};
+
+//triangles are stored already resolved, no index lookups so a mapped chunk can be drawn straight from the page cache
+struct Chunk_Triangle {
+    Vector3 vertices[3];
+    Vector3 normal;   //file normal of the first corner, same as the flat rasterizer uses
+    Color color;      //diffuse color of the face material
+};
+
+//----------------------------------------Streamed_Mesh_Class------------------------------
+class Streamed_Mesh {
+    private:
+        struct Resident_Chunk {
+            void* mapping = nullptr;       //page aligned start of the mapping
+            size_t mapping_size = 0;
+            const Chunk_Triangle* triangles = nullptr;
+            std::list<int>::iterator lru_position;
+            uint64_t last_used_frame = 0;
+        };
+
+        int file_descriptor;
+        std::vector<Chunk_Info> chunks;
+        std::vector<Resident_Chunk> residency;
+        std::list<int> lru_order;          //front is the most recently drawn chunk
+        std::vector<int> visible_chunks;
+        size_t memory_budget;
+        size_t resident_bytes;
+        uint64_t frame_index;
+
+        bool page_in(int chunk_index);
+        void page_out(int chunk_index);
+        size_t chunk_bytes(int chunk_index) const;
+
+    public:
+        Streamed_Mesh();
+        ~Streamed_Mesh();
+        Streamed_Mesh(const Streamed_Mesh&) = delete;
+        Streamed_Mesh& operator=(const Streamed_Mesh&) = delete;
+
+        bool open(const std::string& chunk_file_path, size_t memory_budget_bytes);
+        void close();
+
+        //finds the chunks in view, nearest first, pages them in and returns the ones that fit in the budget
+        const std::vector<int>& update_residency(const Camera& camera);
+
+        void set_memory_budget(size_t memory_budget_bytes);
+        size_t get_memory_budget() const { return memory_budget; }
+        size_t get_resident_bytes() const { return resident_bytes; }
+        const std::vector<Chunk_Info>& get_chunks() const { return chunks; }
+        const Chunk_Triangle* get_triangles(int chunk_index) const { return residency[chunk_index].triangles; }
+        size_t get_triangle_count(int chunk_index) const { return chunks[chunk_index].triangle_count; }
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "Thread_Pool.h"
+#include <atomic>
+#include <algorithm>
+
+Thread_Pool::Thread_Pool(int thread_count) : jobs(16), jobs_head(0), jobs_count(0), unfinished_jobs(0), stopping(false) {
+    if (thread_count <= 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        workers.emplace_back(&Thread_Pool::worker_loop, this);
+    }
+}
+
+Thread_Pool::~Thread_Pool() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void Thread_Pool::worker_loop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex);
+            job_available.wait(lock, [this] { return stopping || jobs_count > 0; });
+            if (stopping && jobs_count == 0) {
+                return;
+            }
+            job = std::move(jobs[jobs_head]);
+            jobs[jobs_head] = nullptr;
+            jobs_head = (jobs_head + 1) % jobs.size();
+            jobs_count--;
+        }
+        job();
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            unfinished_jobs--;
+        }
+        jobs_finished.notify_all();
+    }
+}
+
+void Thread_Pool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        if (jobs_count == jobs.size()) {
+            //full, unroll the ring into a bigger one
+            std::vector<std::function<void()>> grown(jobs.size() * 2);
+            for (size_t i = 0; i < jobs_count; ++i) {
+                grown[i] = std::move(jobs[(jobs_head + i) % jobs.size()]);
+            }
+            jobs.swap(grown);
+            jobs_head = 0;
+        }
+        jobs[(jobs_head + jobs_count) % jobs.size()] = std::move(job);
+        jobs_count++;
+        unfinished_jobs++;
+    }
+    job_available.notify_one();
+}
+
+void Thread_Pool::wait() {
+    std::unique_lock<std::mutex> lock(jobs_mutex);
+    jobs_finished.wait(lock, [this] { return unfinished_jobs == 0; });
+}
+
+void Thread_Pool::parallel_for(int count, const std::function<void(int)>& body) {
+    //indices are handed out one at a time so uneven work (like a tile full of geometry) balances itself,
+    //and the caller helps out instead of sleeping, so this still finishes if the workers are busy with other jobs
+    struct Shared_State {
+        const std::function<void(int)>* body;
+        int count;
+        std::atomic<int> next_index;
+        std::atomic<int> helpers_running;
+        std::mutex done_mutex;
+        std::condition_variable done;
+
+        void run() {
+            for (int i = next_index++; i < count; i = next_index++) {
+                (*body)(i);
+            }
+        }
+    };
+    Shared_State state;
+    state.body = &body;
+    state.count = count;
+    state.next_index = 0;
+    state.helpers_running = 0;
+
+    int helper_count = std::min(get_thread_count(), count - 1);
+    for (int i = 0; i < helper_count; ++i) {
+        state.helpers_running++;
+        //only captures one pointer so the std::function keeps it inline instead of allocating
+        Shared_State* shared = &state;
+        submit([shared]() {
+            shared->run();
+            std::lock_guard<std::mutex> lock(shared->done_mutex);
+            shared->helpers_running--;
+            shared->done.notify_one();
+        });
+    }
+    state.run();
+
+    std::unique_lock<std::mutex> lock(state.done_mutex);
+    state.done.wait(lock, [&] { return state.helpers_running == 0; });
+}
@@ -0,0 +1,43 @@
+/*
+File Description:
+- A fixed set of worker threads fed from a shared job queue. Used for anything
+- that should run off the render thread or be split across cores, like ray
+- traced tiles.
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+//Standard C Libraries
+#include <vector>             //worker list
+#include <thread>             //workers
+#include <mutex>              //guards the queue
+#include <condition_variable> //wakes sleeping workers
+#include <functional>         //jobs
+
+class Thread_Pool {
+    private:
+        std::vector<std::thread> workers;
+        std::vector<std::function<void()>> jobs; //ring buffer of pending jobs, only reallocates when it fills up
+        size_t jobs_head;
+        size_t jobs_count;
+        std::mutex jobs_mutex;
+        std::condition_variable job_available;
+        std::condition_variable jobs_finished;
+        int unfinished_jobs; //queued plus currently running
+        bool stopping;
+
+        void worker_loop();
+
+    public:
+        explicit Thread_Pool(int thread_count = 0); //0 uses one thread per core
+        ~Thread_Pool();
+
+        void submit(std::function<void()> job);
+        void wait();
+        //runs body(0..count-1) across the workers and the calling thread, returns once every index is done
+        void parallel_for(int count, const std::function<void(int)>& body);
+
+        int get_thread_count() const { return static_cast<int>(workers.size()); }
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Utilities.h"
+#include <atomic>
 
 float dot_product(const Vector3& v1, const Vector3& v2) {
     return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
@@ -74,3 +75,80 @@ Vector3 reflect(const Vector3& incident, const Vector3& normal) {
 
 
 
+
+Quaternion quaternion_from_axis_angle(const Vector3& axis, float angle) {
+    Vector3 unit_axis = normalize(axis);
+    float half_sine = std::sin(angle * 0.5f);
+    return Quaternion(unit_axis.x * half_sine, unit_axis.y * half_sine, unit_axis.z * half_sine, std::cos(angle * 0.5f));
+}
+
+Quaternion slerp(const Quaternion& from, const Quaternion& to, float t) {
+    //q and -q are the same rotation, flip one so this goes the short way around
+    float cosine = from.x * to.x + from.y * to.y + from.z * to.z + from.w * to.w;
+    Quaternion target = to;
+    if (cosine < 0.0f) {
+        cosine = -cosine;
+        target = Quaternion(-to.x, -to.y, -to.z, -to.w);
+    }
+
+    float from_weight, to_weight;
+    if (cosine > 0.9995f) {
+        //nearly the same rotation, the sine below would blow up so blend linearly and renormalize
+        from_weight = 1.0f - t;
+        to_weight = t;
+    } else {
+        float angle = std::acos(cosine);
+        float inverse_sine = 1.0f / std::sin(angle);
+        from_weight = std::sin((1.0f - t) * angle) * inverse_sine;
+        to_weight = std::sin(t * angle) * inverse_sine;
+    }
+    Quaternion result(
+        from.x * from_weight + target.x * to_weight,
+        from.y * from_weight + target.y * to_weight,
+        from.z * from_weight + target.z * to_weight,
+        from.w * from_weight + target.w * to_weight
+    );
+    float length = std::sqrt(result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w);
+    return Quaternion(result.x / length, result.y / length, result.z / length, result.w / length);
+}
+
+Matrix4 compose_transform(const Vector3& translation, const Quaternion& rotation, const Vector3& scale) {
+    const Quaternion& q = rotation;
+    return Matrix4(
+        (1 - 2 * (q.y * q.y + q.z * q.z)) * scale.x, 2 * (q.x * q.y - q.z * q.w) * scale.y,       2 * (q.x * q.z + q.y * q.w) * scale.z,       translation.x,
+        2 * (q.x * q.y + q.z * q.w) * scale.x,       (1 - 2 * (q.x * q.x + q.z * q.z)) * scale.y, 2 * (q.y * q.z - q.x * q.w) * scale.z,       translation.y,
+        2 * (q.x * q.z - q.y * q.w) * scale.x,       2 * (q.y * q.z + q.x * q.w) * scale.y,       (1 - 2 * (q.x * q.x + q.y * q.y)) * scale.z, translation.z,
+        0, 0, 0, 1
+    );
+}
+
+Matrix4 affine_inverse(const Matrix4& mat) {
+    //invert the upper 3x3 with cofactors, then move the translation back through it
+    const float (*m)[4] = mat.matrix;
+    float cofactor_00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float cofactor_01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float cofactor_02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    float determinant = m[0][0] * cofactor_00 + m[0][1] * cofactor_01 + m[0][2] * cofactor_02;
+    float inverse_determinant = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+
+    Matrix4 result;
+    result.matrix[0][0] = cofactor_00 * inverse_determinant;
+    result.matrix[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inverse_determinant;
+    result.matrix[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inverse_determinant;
+    result.matrix[1][0] = cofactor_01 * inverse_determinant;
+    result.matrix[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inverse_determinant;
+    result.matrix[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inverse_determinant;
+    result.matrix[2][0] = cofactor_02 * inverse_determinant;
+    result.matrix[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inverse_determinant;
+    result.matrix[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inverse_determinant;
+    for (int row = 0; row < 3; ++row) {
+        result.matrix[row][3] = -(result.matrix[row][0] * m[0][3] + result.matrix[row][1] * m[1][3] + result.matrix[row][2] * m[2][3]);
+    }
+    return result;
+}
+
+uint64_t next_revision() {
+    //shared by every thread, the asset loader builds models off the main thread
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
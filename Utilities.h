@@ -4,7 +4,9 @@
 #include <tuple>
 #include <cmath>
 #include <iostream>
+#include <cstdint>
 
+//window size, the internal render resolution can be lower, see Screen::set_render_resolution
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 640;
 
@@ -86,6 +88,11 @@ struct Vector3 {
     }
 };
 
+struct Ray {
+    Vector3 origin;
+    Vector3 direction;  //not required to be normalized, hit distances are in multiples of it
+};
+
 struct Vector4 {
     float x, y, z, w;
 
@@ -150,7 +157,29 @@ struct Matrix4{
     
 };
 
+//unit quaternion rotation, w is the real part
+struct Quaternion {
+    float x, y, z, w;
 
+    Quaternion() : x(0), y(0), z(0), w(1) {}  // Default constructor, no rotation
+    Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+    Quaternion operator*(const Quaternion& other) const {
+        return {
+            w * other.x + x * other.w + y * other.z - z * other.y,
+            w * other.y - x * other.z + y * other.w + z * other.x,
+            w * other.z + x * other.y - y * other.x + z * other.w,
+            w * other.w - x * other.x - y * other.y - z * other.z
+        };
+    }
+};
+
+Quaternion quaternion_from_axis_angle(const Vector3& axis, float angle);
+Quaternion slerp(const Quaternion& from, const Quaternion& to, float t);
+//translation * rotation * scale, the usual order for a joint or node transform
+Matrix4 compose_transform(const Vector3& translation, const Quaternion& rotation, const Vector3& scale);
+//inverse of a matrix with nothing in the bottom row but 0 0 0 1
+Matrix4 affine_inverse(const Matrix4& mat);
 
 Vector4 matrix_transform(const Matrix4& mat, const Vector4& vec);
 Vector4 to_vector4(const Vector3& vec);
@@ -164,6 +193,9 @@ Vector3 normalize(const Vector3& v);
 bool is_point_inside_triangle(int x, int y, const Vector3& v0, const Vector3& v1, const Vector3& v2);
 Vector3 reflect(const Vector3& incident, const Vector3& normal);
 
+//a new stamp every call, never repeats, models and cameras keep one to tell whether they changed since it was last seen
+uint64_t next_revision();
+
 
 
 #endif
\ No newline at end of file
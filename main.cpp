@@ -1,14 +1,61 @@
 #include "Screen.h"
 #include "Model.h"
 #include "Loader.h"
-int main(){
+#include "Resolution_Scaler.h"
+#include "Asset_Manager.h"
+#include "Frame_Capture.h"
+#include "Allocation_Counter.h"
+#include <memory>
+#include <cstring>
+#include <iostream>
+int main(int argc, char* argv[]){
+    //optional recording: --capture <path prefix or pipe command> [--format ppm|png|pipe] [--block]
+    //--still leaves the model where it is, nothing changes so the frames after the first cost almost nothing
+    //--prepass draws depth before shading so hidden pixels are never shaded
+    //--full-redraw clears and draws the whole frame every time through render_models, the path with occlusion culling
+    std::string capture_path;
+    Capture_Format capture_format = Capture_Format::PNG;
+    Queue_Full_Policy capture_policy = Queue_Full_Policy::DROP;
+    bool still = false;
+    bool depth_prepass = false;
+    bool full_redraw = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "ppm") {
+                capture_format = Capture_Format::PPM;
+            } else if (format == "png") {
+                capture_format = Capture_Format::PNG;
+            } else if (format == "pipe") {
+                capture_format = Capture_Format::RAW_PIPE;
+            } else {
+                std::cerr << "Unknown capture format: " << format << ", expected ppm, png or pipe" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--block") == 0) {
+            capture_policy = Queue_Full_Policy::BLOCK;
+        } else if (std::strcmp(argv[i], "--still") == 0) {
+            still = true;
+        } else if (std::strcmp(argv[i], "--prepass") == 0) {
+            depth_prepass = true;
+        } else if (std::strcmp(argv[i], "--full-redraw") == 0) {
+            full_redraw = true;
+        }
+    }
+    std::unique_ptr<Frame_Capture> frame_capture;
+    if (!capture_path.empty()) {
+        frame_capture.reset(new Frame_Capture(capture_format, capture_path, 4, capture_policy));
+    }
 
     Screen screen;
+    screen.depth_prepass = depth_prepass;
     std::string object_path = "./assets/test.obj";
     std::string material_path = "./assets/test.mtl";
-    Model model =  Loader::load_obj(object_path,material_path);
-    model.translate(0,0,0);
-    model.find_origin();
+    //loads in the background, a placeholder cube gets drawn until it is ready
+    Asset_Manager assets;
+    Asset_Handle model_handle = assets.load(object_path,material_path);
 
     Camera camera = Camera(Vector3(-20, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, -1), 45.0f, 1.0f , 0.5f, 200.0f);
     screen.camera = camera;
@@ -17,17 +64,60 @@ int main(){
     screen.light_direction = light_direction;
 
     
-    screen.camera.set_forward(model.get_center_of_origin()-screen.camera.get_position());
+    screen.camera.set_forward(assets.get(model_handle).get_center_of_origin()-screen.camera.get_position());
     screen.camera.update_views();
     screen.camera.print_frustum_world_bounds();
 
+    //drop the internal resolution whenever rendering takes longer than ~60fps allows
+    Resolution_Scaler resolution_scaler(SCREEN_WIDTH, SCREEN_HEIGHT, 16.0f);
+
+    uint64_t frame_number = 0;
+    std::vector<Model*> scene_models;
     while(true){
-        screen.clear_display();
-        model.rotate(0.01,0.02,0.03);
+#ifdef DIMENSION_COUNT_ALLOCATIONS
+        uint64_t allocations_before = get_allocation_count();
+#endif
+        //swap in anything that finished loading (or was edited on disk) before this frame starts
+        if (assets.update() > 0) {
+            screen.camera.set_forward(assets.get(model_handle).get_center_of_origin()-screen.camera.get_position());
+            screen.camera.update_views();
+        }
+        Model& model = assets.get(model_handle);
+
+        resolution_scaler.begin_frame();
+        screen.set_render_resolution(resolution_scaler.get_render_width(), resolution_scaler.get_render_height());
+        if (!still) {
+            model.rotate(0.01,0.02,0.03);
+        }
 
-        screen.render_model_gourand(model);
-        SDL_RenderPresent(screen.renderer);
-        screen.input();
+        scene_models.assign(1, &model);
+        if (full_redraw) {
+            screen.clear_display();
+            screen.render_models(scene_models);
+            //every couple of seconds is enough to see what the culling buys without flooding the console
+            if (frame_number % 120 == 0) {
+                screen.get_occlusion_culler().print_stats();
+            }
+        } else {
+            //only the part of the screen the model moved over gets drawn again
+            screen.render_scene(scene_models);
+        }
+        resolution_scaler.end_frame();
+        screen.present();
+        if (frame_capture) {
+            screen.capture(*frame_capture);
+        }
+#ifdef DIMENSION_COUNT_ALLOCATIONS
+        //once everything has warmed up a frame should not touch the heap at all, this shows any that still do
+        uint64_t frame_allocations = get_allocation_count() - allocations_before;
+        if (frame_allocations > 0) {
+            std::cout << "frame " << frame_number << ": " << frame_allocations << " heap allocations" << std::endl;
+        }
+#endif
+        frame_number++;
+        if (!screen.input()) {
+            break;
+        }
         SDL_Delay(30);
     }
 
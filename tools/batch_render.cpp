@@ -0,0 +1,310 @@
+/*
+File Description:
+- Headless batch renderer for thumbnails and turntables. Reads a manifest of
+- OBJ/MTL pairs and viewpoints, renders every asset from every viewpoint on a
+- pool of workers (each with its own frame buffer) and writes PNGs. Nothing
+- here touches SDL, so it runs on machines without a display.
+- Lives in tools/ so the main program still builds from the top level *.cpp,
+- build it with everything except main.cpp and Screen.cpp:
+-   g++ -std=c++17 -O2 -pthread -I. tools/batch_render.cpp $(ls *.cpp | grep -v -e main.cpp -e Screen.cpp) -o batch_render
+- Manifest, one entry per line, # starts a comment:
+-   size <width> <height>                            output resolution, default 256 256
+-   view <name> <azimuth degrees> <elevation degrees> a fixed viewpoint, every asset gets rendered from it
+-   turntable <frames> <elevation degrees>            frames evenly spaced around the asset
+-   asset <obj path> <mtl path> <output prefix>      writes <prefix>_<view>.png and <prefix>_turn_NN.png
+- Usage:
+-   batch_render <manifest> [--threads N] [--flat] [--quantized]
+- --quantized renders from a Quantized_Mesh copy of each asset and frees the
+- model's float vertex streams, so only the compact copy stays resident.
+- Compare the reported vertex memory and raster time against a run without it.
+*/
+
+//Standard C Libraries
+#include <iostream>   //reporting
+#include <fstream>    //manifest
+#include <sstream>    //manifest lines
+#include <string>
+#include <vector>
+#include <atomic>     //next asset, counters
+#include <thread>     //core count
+#include <chrono>     //throughput
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <sys/resource.h> //peak memory
+//Created Files
+#include "Loader.h"
+#include "Rasterizer.h"
+#include "Frame_Buffer.h"
+#include "Frame_Capture.h"
+#include "Thread_Pool.h"
+#include "Quantized_Mesh.h"
+
+namespace {
+    const float PI = 3.14159265f;
+    const float FIELD_OF_VIEW = 0.8f;  //radians
+    const float NEAR_PLANE = 0.5f;
+    const Color BACKGROUND_COLOR = Color{115 / 255.0f, 155 / 255.0f, 155 / 255.0f, 1.0f};
+
+    struct View {
+        std::string name;
+        float azimuth;    //radians around the vertical axis
+        float elevation;  //radians above the horizon
+    };
+
+    struct Asset_Entry {
+        std::string obj_path;
+        std::string mtl_path;
+        std::string output_prefix;
+    };
+
+    struct Manifest {
+        int width = 256;
+        int height = 256;
+        std::vector<View> views;
+        std::vector<Asset_Entry> assets;
+    };
+
+    struct Render_Options {
+        bool smooth_shading = true;
+        bool quantized = false;
+    };
+
+    //everything one worker renders into, reused for every asset it picks up
+    struct Render_Context {
+        Frame_Buffer frame;
+        std::vector<uint8_t> rgb;
+        Quantized_Mesh quantized_mesh;
+        double raster_seconds = 0.0;
+        size_t float_vertex_bytes = 0;
+        size_t quantized_vertex_bytes = 0;
+    };
+
+    //one raster pass, reading the vertex data from the quantized copy when there is one
+    template <typename Vertex_Policy, typename Shading_Policy>
+    void draw_pass(Frame_Buffer& frame, const Camera& camera, const Model& model, const Quantized_Mesh* quantized_mesh, const Raster_Settings& settings) {
+        if (quantized_mesh) {
+            rasterize_quantized_model<Vertex_Policy, Shading_Policy>(frame, camera, model, *quantized_mesh, settings);
+        } else {
+            rasterize_model<Vertex_Policy, Shading_Policy>(frame, camera, model, settings);
+        }
+    }
+
+    bool read_manifest(const std::string& path, Manifest& manifest) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open manifest: " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line)) {
+            line_number++;
+            line = line.substr(0, line.find('#'));
+            std::istringstream iss(line);
+            std::string keyword;
+            if (!(iss >> keyword)) {
+                continue;
+            }
+            bool parsed = true;
+            if (keyword == "size") {
+                parsed = static_cast<bool>(iss >> manifest.width >> manifest.height) && manifest.width > 0 && manifest.height > 0;
+            } else if (keyword == "view") {
+                View view;
+                parsed = static_cast<bool>(iss >> view.name >> view.azimuth >> view.elevation);
+                view.azimuth *= PI / 180.0f;
+                view.elevation *= PI / 180.0f;
+                manifest.views.push_back(view);
+            } else if (keyword == "turntable") {
+                int frames;
+                float elevation;
+                parsed = static_cast<bool>(iss >> frames >> elevation) && frames > 0;
+                for (int i = 0; parsed && i < frames; ++i) {
+                    char name[32];
+                    std::snprintf(name, sizeof(name), "turn_%02d", i);
+                    manifest.views.push_back(View{name, 2.0f * PI * i / frames, elevation * PI / 180.0f});
+                }
+            } else if (keyword == "asset") {
+                Asset_Entry asset;
+                parsed = static_cast<bool>(iss >> asset.obj_path >> asset.mtl_path >> asset.output_prefix);
+                manifest.assets.push_back(asset);
+            } else {
+                parsed = false;
+            }
+            if (!parsed) {
+                std::cerr << path << ":" << line_number << ": could not read \"" << line << "\"" << std::endl;
+                return false;
+            }
+        }
+        if (manifest.views.empty()) {
+            manifest.views.push_back(View{"front", 0.0f, 0.0f});
+        }
+        return true;
+    }
+
+    //box around the vertices themselves, the meshlet spheres behind get_bounds are loose enough to shrink a thumbnail to a third
+    void get_vertex_bounds(const Model& model, Vector3& bounds_min, Vector3& bounds_max) {
+        const std::vector<Vector3>& vertices = model.get_vertices();
+        bounds_min = vertices.empty() ? Vector3(0, 0, 0) : vertices[0];
+        bounds_max = bounds_min;
+        for (const Vector3& vertex : vertices) {
+            bounds_min = Vector3(std::min(bounds_min.x, vertex.x), std::min(bounds_min.y, vertex.y), std::min(bounds_min.z, vertex.z));
+            bounds_max = Vector3(std::max(bounds_max.x, vertex.x), std::max(bounds_max.y, vertex.y), std::max(bounds_max.z, vertex.z));
+        }
+    }
+
+    //camera on a sphere around the model's bounds, far enough back that the whole thing fits
+    Camera frame_model(const Vector3& bounds_min, const Vector3& bounds_max, const View& view, float aspect_ratio) {
+        Vector3 center = (bounds_min + bounds_max) * 0.5f;
+        Vector3 half_extent = (bounds_max - bounds_min) * 0.5f;
+        float radius = std::max(std::sqrt(dot_product(half_extent, half_extent)), 1e-3f);
+        float distance = radius / std::sin(FIELD_OF_VIEW * 0.5f) * 1.05f;
+
+        //the models face down -x like the main program's camera sees them
+        Vector3 offset(-std::cos(view.elevation) * std::cos(view.azimuth), std::sin(view.elevation), -std::cos(view.elevation) * std::sin(view.azimuth));
+        Vector3 position = center + offset * distance;
+        //the projection divides by 2fn/(f-n) times depth, which is only plain depth with a near plane of 0.5, so keep that one
+        return Camera(position, Vector3(0, 1, 0), -offset, FIELD_OF_VIEW, aspect_ratio, NEAR_PLANE, std::max(distance + radius * 2.0f, NEAR_PLANE * 4.0f));
+    }
+
+    //renders every view of one asset, returns how many images got written
+    int render_asset(const Asset_Entry& asset, const Manifest& manifest, const Render_Options& options, Render_Context& context) {
+        Model model = Loader::load_obj(asset.obj_path, asset.mtl_path);
+        if (model.get_faces().empty()) {
+            std::cerr << "Skipping " << asset.obj_path << ", nothing loaded" << std::endl;
+            return 0;
+        }
+        context.frame.resize(manifest.width, manifest.height);
+        context.rgb.resize(static_cast<size_t>(manifest.width) * manifest.height * 3);
+
+        //taken before the quantized path throws the float vertices away
+        Vector3 bounds_min, bounds_max;
+        get_vertex_bounds(model, bounds_min, bounds_max);
+
+        const Quantized_Mesh* quantized_mesh = nullptr;
+        context.float_vertex_bytes += Quantized_Mesh::get_float_memory_bytes(model);
+        if (options.quantized) {
+            context.quantized_mesh.build(model);
+            quantized_mesh = &context.quantized_mesh;
+            context.quantized_vertex_bytes += context.quantized_mesh.get_memory_bytes();
+            //nothing below reads the floats again, dropping them is what actually leaves room for more models
+            model.release_vertex_streams();
+        }
+
+        bool translucent = model.has_translucent_materials();
+        int written = 0;
+        for (const View& view : manifest.views) {
+            Camera camera = frame_model(bounds_min, bounds_max, view, static_cast<float>(manifest.width) / manifest.height);
+            Raster_Settings settings;
+            settings.light_direction = -normalize(camera.get_forward()); //light from the camera, every view comes out lit
+            context.frame.clear(pack_color(BACKGROUND_COLOR));
+            auto raster_start = std::chrono::steady_clock::now();
+            if (options.smooth_shading) {
+                draw_pass<Vertex_Lighting, Gouraud_Shading>(context.frame, camera, model, quantized_mesh, settings);
+            } else {
+                draw_pass<No_Vertex_Attributes, Flat_Shading>(context.frame, camera, model, quantized_mesh, settings);
+            }
+            if (translucent) {
+                if (options.smooth_shading) {
+                    draw_pass<Vertex_Lighting, Translucent_Shading<Gouraud_Shading>>(context.frame, camera, model, quantized_mesh, settings);
+                } else {
+                    draw_pass<No_Vertex_Attributes, Translucent_Shading<Flat_Shading>>(context.frame, camera, model, quantized_mesh, settings);
+                }
+                context.frame.resolve_translucency();
+            }
+            context.raster_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - raster_start).count();
+
+            //the projection comes out turned half way around (see the sign of w in Camera::set_projection_matrix),
+            //reading the pixels back to front turns the image upright again
+            size_t pixel_count = context.frame.color.size();
+            for (size_t i = 0; i < pixel_count; ++i) {
+                uint32_t pixel = context.frame.color[pixel_count - 1 - i];
+                context.rgb[i * 3 + 0] = static_cast<uint8_t>(pixel >> 16);
+                context.rgb[i * 3 + 1] = static_cast<uint8_t>(pixel >> 8);
+                context.rgb[i * 3 + 2] = static_cast<uint8_t>(pixel);
+            }
+            std::string output_path = asset.output_prefix + "_" + view.name + ".png";
+            if (write_png(output_path, context.rgb.data(), manifest.width, manifest.height)) {
+                written++;
+            } else {
+                std::cerr << "Failed to write " << output_path << std::endl;
+            }
+        }
+        return written;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <manifest> [--threads N] [--flat] [--quantized]" << std::endl;
+        return 1;
+    }
+    int thread_count = 0;
+    Render_Options options;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--flat") == 0) {
+            options.smooth_shading = false;
+        } else if (std::strcmp(argv[i], "--quantized") == 0) {
+            options.quantized = true;
+        }
+    }
+
+    Manifest manifest;
+    if (!read_manifest(argv[1], manifest)) {
+        return 1;
+    }
+
+    //the calling thread works too, so one fewer pool thread than requested
+    if (thread_count <= 0) {
+        thread_count = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    thread_count = std::max(1, thread_count); //hardware_concurrency is allowed to say 0 when it cannot tell
+    Thread_Pool workers(std::max(1, thread_count - 1));
+    int worker_count = thread_count;
+    std::vector<Render_Context> contexts(worker_count);
+    std::atomic<int> next_asset(0);
+    std::atomic<int> images_written(0);
+    std::atomic<int> assets_failed(0);
+
+    auto start = std::chrono::steady_clock::now();
+    //one index per worker rather than per asset, so each keeps its own context while it pulls assets off the list
+    workers.parallel_for(worker_count, [&](int worker) {
+        for (int i = next_asset++; i < static_cast<int>(manifest.assets.size()); i = next_asset++) {
+            int written = render_asset(manifest.assets[i], manifest, options, contexts[worker]);
+            images_written += written;
+            if (written == 0) {
+                assets_failed++;
+            }
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    size_t asset_count = manifest.assets.size();
+    std::cout << "rendered " << asset_count - assets_failed << "/" << asset_count << " assets, " << images_written << " images with "
+              << worker_count << " workers in " << seconds << "s" << std::endl;
+    std::cout << "  " << (seconds > 0 ? asset_count / seconds : 0.0) << " assets/s, " << (seconds > 0 ? images_written / seconds : 0.0) << " images/s" << std::endl;
+    std::cout << "  peak memory " << usage.ru_maxrss / 1024.0 << " MB" << std::endl;  //ru_maxrss is in kilobytes on linux
+
+    double raster_seconds = 0.0;
+    size_t float_vertex_bytes = 0, quantized_vertex_bytes = 0;
+    for (const Render_Context& context : contexts) {
+        raster_seconds += context.raster_seconds;
+        float_vertex_bytes += context.float_vertex_bytes;
+        quantized_vertex_bytes += context.quantized_vertex_bytes;
+    }
+    std::cout << "  raster time " << raster_seconds * 1000.0 << " ms across workers, " << (images_written > 0 ? raster_seconds * 1000.0 / images_written : 0.0)
+              << " ms per image" << std::endl;
+    //what stays resident per model while it renders, the float streams are freed once the quantized copy is built
+    if (options.quantized) {
+        std::cout << "  resident vertex data " << quantized_vertex_bytes / 1024.0 << " KB quantized, " << float_vertex_bytes / 1024.0 << " KB as floats ("
+                  << (float_vertex_bytes > 0 ? 100.0 * (float_vertex_bytes - quantized_vertex_bytes) / float_vertex_bytes : 0.0)
+                  << "% saved, the floats only live until the copy is built)" << std::endl;
+    } else {
+        std::cout << "  resident vertex data " << float_vertex_bytes / 1024.0 << " KB as floats" << std::endl;
+    }
+    return assets_failed > 0 ? 1 : 0;
+}